@@ -0,0 +1,305 @@
+/*!
+ * \file CalibrationAccumulator.cpp
+ * \brief Class responsible for online camera calibration from a stream of pattern detections - methods definition.
+ */
+
+#include "CalibrationAccumulator.hpp"
+
+#include <cfloat>
+
+#include <opencv2/calib3d/calib3d.hpp>
+
+namespace Processors {
+namespace CalibrationAccumulator {
+
+CalibrationAccumulator::CalibrationAccumulator(const std::string & n) :
+	Base::Component(n),
+	prop_width("width", 640),
+	prop_height("height", 480),
+	prop_max_views("max_views", 40),
+	prop_min_views("min_views", 6),
+	prop_min_distance("min_distance", 0.05f),
+	prop_update_every("update_every", 1),
+	prop_fix_k3("fix_k3", true),
+	prop_zero_tangent_dist("zero_tangent_dist", false)
+{
+	registerProperty(prop_width);
+	registerProperty(prop_height);
+	registerProperty(prop_max_views);
+	registerProperty(prop_min_views);
+	registerProperty(prop_min_distance);
+	registerProperty(prop_update_every);
+	registerProperty(prop_fix_k3);
+	registerProperty(prop_zero_tangent_dist);
+
+	CLOG(LTRACE) << "Constructed";
+}
+
+CalibrationAccumulator::~CalibrationAccumulator() {
+	CLOG(LTRACE) << "Destroyed";
+}
+
+
+void CalibrationAccumulator::prepareInterface() {
+	// Register streams.
+	registerStream("in_chessboard", &in_chessboard);
+	registerStream("in_gridpattern", &in_gridpattern);
+	registerStream("in_camera_info", &in_camera_info);
+	registerStream("out_camera_info", &out_camera_info);
+	registerStream("out_rms", &out_rms);
+
+	// Register handlers - add views, activated when new detections arrive.
+	registerHandler("onNewChessboard", boost::bind(&CalibrationAccumulator::onNewChessboard, this));
+	addDependency("onNewChessboard", &in_chessboard);
+
+	registerHandler("onNewGridPattern", boost::bind(&CalibrationAccumulator::onNewGridPattern, this));
+	addDependency("onNewGridPattern", &in_gridpattern);
+
+	// Register handlers - sets the initial estimate, activated when new camera info arrives.
+	registerHandler("onNewCameraInfo", boost::bind(&CalibrationAccumulator::onNewCameraInfo, this));
+	addDependency("onNewCameraInfo", &in_camera_info);
+
+	// Register handlers - publishes finished calibrations, activated on every step.
+	registerHandler("publish_result", boost::bind(&CalibrationAccumulator::publishResult, this));
+	addDependency("publish_result", NULL);
+
+	// Register handlers - triggered manually.
+	registerHandler("Reset", boost::bind(&CalibrationAccumulator::onReset, this));
+	registerHandler("Calibrate", boost::bind(&CalibrationAccumulator::onCalibrate, this));
+}
+
+bool CalibrationAccumulator::onInit() {
+	CLOG(LTRACE) << "initialize\n";
+
+	selector.configure(prop_max_views, prop_min_distance, cv::Size(prop_width, prop_height));
+	accepted = 0;
+	dirty = false;
+	job_ready = busy = result_ready = false;
+	generation = 0;
+	stop_flag = false;
+
+	worker.reset(new boost::thread(boost::bind(&CalibrationAccumulator::workerLoop, this)));
+
+	return true;
+}
+
+bool CalibrationAccumulator::onFinish() {
+	CLOG(LTRACE) << "onFinish";
+
+	if (worker) {
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			stop_flag = true;
+		}
+		job_available.notify_one();
+		// Running calibration is finished first.
+		worker->join();
+		worker.reset();
+	}//: if
+
+	return true;
+}
+
+void CalibrationAccumulator::onNewChessboard() {
+	CLOG(LTRACE) << "onNewChessboard";
+	addView(in_chessboard.read());
+}
+
+void CalibrationAccumulator::onNewGridPattern() {
+	CLOG(LTRACE) << "onNewGridPattern";
+	addView(in_gridpattern.read());
+}
+
+void CalibrationAccumulator::onNewCameraInfo() {
+	CLOG(LTRACE) << "onNewCameraInfo";
+	Types::CameraInfo info = in_camera_info.read();
+	if (!camera_matrix.empty()) {
+		// Own estimate is better than the initial one.
+		return;
+	}//: if
+	info.cameraMatrix().convertTo(camera_matrix, CV_64F);
+	info.distCoeffs().convertTo(dist_coeffs, CV_64F);
+	CLOG(LDEBUG) << "Initial estimate set";
+}
+
+void CalibrationAccumulator::onReset() {
+	CLOG(LDEBUG) << "onReset";
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		// Pending job and result were computed from the dropped views, the running job is discarded when done.
+		++generation;
+		job_ready = false;
+		result_ready = false;
+	}
+	selector.clear();
+	camera_matrix.release();
+	dist_coeffs.release();
+	accepted = 0;
+	dirty = false;
+}
+
+void CalibrationAccumulator::onCalibrate() {
+	CLOG(LDEBUG) << "onCalibrate";
+	publishResult();
+	dirty = true;
+	requestCalibration();
+}
+
+void CalibrationAccumulator::addView(const Types::Objects3D::Object3D & object_) {
+	publishResult();
+
+	try {
+		if (!selector.offer(object_.getImagePoints(), object_.getModelPointsHandle()))
+			return;
+	} catch (const std::exception & ex) {
+		CLOG(LWARNING) << "Incomplete detection skipped: " << ex.what();
+		return;
+	}//: catch
+
+	dirty = true;
+	++accepted;
+	CLOG(LDEBUG) << "View accepted - " << selector.getViews().size() << " views, coverage " << selector.coverage() * 100 << "%";
+
+	if (accepted >= prop_update_every)
+		requestCalibration();
+}
+
+void CalibrationAccumulator::requestCalibration() {
+	const std::vector<CalibrationView> & views = selector.getViews();
+	if (!dirty || (int) views.size() < std::max<int>(prop_min_views, 3))
+		return;
+
+	boost::mutex::scoped_lock lock(mutex);
+	if (busy || job_ready) {
+		// The worker takes the current views once it is done.
+		return;
+	}//: if
+
+	// Copy of the bounded view set - the worker does not touch the selector.
+	job.object_points.resize(views.size());
+	job.image_points.resize(views.size());
+	for (size_t i = 0; i < views.size(); ++i) {
+		job.object_points[i] = *views[i].model_points;
+		job.image_points[i] = views[i].image_points;
+	}//: for
+
+	job.image_size = cv::Size(prop_width, prop_height);
+	job.generation = generation;
+	job.flags = 0;
+	if (!camera_matrix.empty()) {
+		camera_matrix.copyTo(job.camera_matrix);
+		dist_coeffs.copyTo(job.dist_coeffs);
+		job.flags |= cv::CALIB_USE_INTRINSIC_GUESS;
+	} else {
+		job.camera_matrix.release();
+		job.dist_coeffs.release();
+	}//: else
+	if (prop_fix_k3)
+		job.flags |= cv::CALIB_FIX_K3;
+	if (prop_zero_tangent_dist)
+		job.flags |= cv::CALIB_ZERO_TANGENT_DIST;
+
+	job_ready = true;
+	dirty = false;
+	accepted = 0;
+	job_available.notify_one();
+}
+
+void CalibrationAccumulator::publishResult() {
+	Types::CameraInfo info(prop_width, prop_height);
+	double rms;
+	size_t views;
+	bool ready;
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		ready = result_ready;
+		if (ready) {
+			result_ready = false;
+			result_camera_matrix.copyTo(camera_matrix);
+			result_dist_coeffs.copyTo(dist_coeffs);
+			rms = result_rms;
+			views = result_views;
+		}//: if
+	}
+
+	if (!ready) {
+		// Views accepted while the worker was busy (e.g. with a job dropped by reset) wait for it to become idle.
+		if (accepted >= prop_update_every)
+			requestCalibration();
+		return;
+	}//: if
+
+	// CameraInfo keeps parameters in single precision.
+	cv::Mat K, D;
+	camera_matrix.convertTo(K, CV_32F);
+	dist_coeffs.reshape(1, 1).convertTo(D, CV_32F);
+	info.setCameraMatrix(K);
+	info.setDistCoeffs(D);
+
+	CLOG(LINFO) << "Calibration refined with " << views << " views, RMS " << rms;
+	out_camera_info.write(info);
+	out_rms.write(rms);
+
+	// Views collected during the calibration are used by the next one.
+	requestCalibration();
+}
+
+void CalibrationAccumulator::workerLoop() {
+	Job current;
+	for (;;) {
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			while (!job_ready && !stop_flag)
+				job_available.wait(lock);
+			if (stop_flag)
+				return;
+			current.object_points.swap(job.object_points);
+			current.image_points.swap(job.image_points);
+			current.camera_matrix = job.camera_matrix.clone();
+			current.dist_coeffs = job.dist_coeffs.clone();
+			current.image_size = job.image_size;
+			current.flags = job.flags;
+			current.generation = job.generation;
+			job_ready = false;
+			busy = true;
+		}
+
+		cv::Mat K = current.camera_matrix, D = current.dist_coeffs;
+		std::vector<cv::Mat> rvecs, tvecs;
+		double rms = -1;
+		const int64 start = cv::getTickCount();
+		try {
+			// Starting from the previous estimate the solver converges in a few iterations.
+			rms = cv::calibrateCamera(current.object_points, current.image_points, current.image_size,
+					K, D, rvecs, tvecs, current.flags,
+					cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 30, DBL_EPSILON));
+		} catch (const std::exception & ex) {
+			CLOG(LERROR) << "Calibration failed: " << ex.what();
+		}//: catch
+		CLOG(LDEBUG) << "Calibration with " << current.image_points.size() << " views took "
+				<< 1000.0 * (cv::getTickCount() - start) / cv::getTickFrequency() << " ms";
+
+		boost::mutex::scoped_lock lock(mutex);
+		busy = false;
+		// Results of jobs started before the last reset are dropped.
+		if (rms >= 0 && current.generation == generation) {
+			K.copyTo(result_camera_matrix);
+			D.copyTo(result_dist_coeffs);
+			result_rms = rms;
+			result_views = current.image_points.size();
+			result_ready = true;
+		}//: if
+	}
+}
+
+bool CalibrationAccumulator::onStart() {
+	return true;
+}
+
+bool CalibrationAccumulator::onStop() {
+	return true;
+}
+
+
+}//: namespace CalibrationAccumulator
+}//: namespace Processors
@@ -0,0 +1,224 @@
+/*!
+ * \file CalibrationAccumulator.hpp
+ * \brief Class responsible for online camera calibration from a stream of pattern detections - class declaration.
+ */
+
+
+#ifndef CalibrationAccumulator_HPP_
+#define CalibrationAccumulator_HPP_
+
+#include "Component_Aux.hpp"
+#include "Component.hpp"
+#include "DataStream.hpp"
+#include "Property.hpp"
+
+#include "Types/CameraInfo.hpp"
+#include "Types/Objects3D/Chessboard.hpp"
+#include "Types/Objects3D/GridPattern.hpp"
+
+#include "ViewSelector.hpp"
+
+#include <string>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * \defgroup CalibrationAccumulator CalibrationAccumulator
+ *
+ * \brief Calibrates the camera incrementally from detected chessboards (grids), publishing the current CameraInfo.
+ */
+
+namespace Processors {
+namespace CalibrationAccumulator {
+
+/*!
+ * \class CalibrationAccumulator
+ * \brief Class responsible for online camera calibration.
+ *
+ * Detections are offered to the ViewSelector, which keeps a bounded set of views covering the image
+ * with diverse poses, so memory and the cost of a calibration do not grow with the number of detections.
+ * Whenever the set changes, the intrinsics are refined (cv::calibrateCamera with CALIB_USE_INTRINSIC_GUESS,
+ * starting from the current estimate) in a worker thread - handlers never wait for the calibration.
+ * Finished calibrations are published on the next step (publish_result handler).
+ * Results are published as Types::CameraInfo, the same way as by CameraInfoProvider (whose in_camera_info
+ * can be connected to out_camera_info to store them).
+ */
+class CalibrationAccumulator : public Base::Component {
+
+public:
+	/*!
+	 * Constructor. Sets ID and startup variables.
+	 */
+	CalibrationAccumulator(const std::string & name = "CalibrationAccumulator");
+
+	/*!
+	 * Destructor.
+	 */
+	virtual ~CalibrationAccumulator();
+
+	virtual void prepareInterface();
+
+protected:
+
+	/*!
+	 * Starts the calibration thread.
+	 */
+	bool onInit();
+
+	/*!
+	 * Stops the calibration thread.
+	 */
+	bool onFinish();
+
+	/*!
+	 * Start component
+	 */
+	bool onStart();
+
+	/*!
+	 * Stop component
+	 */
+	bool onStop();
+
+	/// Input data stream - detected chessboards.
+	Base::DataStreamIn <Types::Objects3D::Chessboard, Base::DataStreamBuffer::Newest> in_chessboard;
+
+	/// Input data stream - detected grids.
+	Base::DataStreamIn <Types::Objects3D::GridPattern, Base::DataStreamBuffer::Newest> in_gridpattern;
+
+	/// Input data stream - initial estimate of the camera parameters (optional).
+	Base::DataStreamIn <Types::CameraInfo, Base::DataStreamBuffer::Newest> in_camera_info;
+
+	/// Current camera parameters.
+	Base::DataStreamOut <Types::CameraInfo> out_camera_info;
+
+	/// RMS reprojection error of the current calibration.
+	Base::DataStreamOut <double> out_rms;
+
+	/*!
+	 * Event handler function - offers the chessboard as a new view.
+	 */
+	void onNewChessboard();
+
+	/*!
+	 * Event handler function - offers the grid as a new view.
+	 */
+	void onNewGridPattern();
+
+	/*!
+	 * Event handler function - sets the initial estimate.
+	 */
+	void onNewCameraInfo();
+
+	/*!
+	 * Event handler function - drops all views and the estimate, triggered manually.
+	 */
+	void onReset();
+
+	/*!
+	 * Event handler function - requests refinement with the current views, triggered manually.
+	 */
+	void onCalibrate();
+
+	/*!
+	 * Event handler function - publishes the result of the finished calibration (if there is any), activated on every step.
+	 */
+	void publishResult();
+
+private:
+	/*!
+	 * Offers the view to the selector and requests refinement if the set changed.
+	 */
+	void addView(const Types::Objects3D::Object3D & object_);
+
+	/*!
+	 * Hands the current views over to the worker (if it is idle).
+	 */
+	void requestCalibration();
+
+	/*!
+	 * Calibration thread.
+	 */
+	void workerLoop();
+
+	/// Selected views.
+	ViewSelector selector;
+
+	/// Current estimate (CV_64F), empty if there is none.
+	cv::Mat camera_matrix;
+	cv::Mat dist_coeffs;
+
+	/// Number of views accepted since the last calibration request.
+	int accepted;
+
+	/// Views changed since the last request.
+	bool dirty;
+
+	/// Calibration job - written by the handlers, taken by the worker.
+	struct Job {
+		std::vector<std::vector<cv::Point3f> > object_points;
+		std::vector<std::vector<cv::Point2f> > image_points;
+		cv::Mat camera_matrix;
+		cv::Mat dist_coeffs;
+		cv::Size image_size;
+		int flags;
+		unsigned generation;
+	};
+	Job job;
+	bool job_ready;
+	bool busy;
+
+	/// Incremented on reset - results of jobs from an older generation are dropped.
+	unsigned generation;
+
+	/// Result of the last calibration - written by the worker.
+	cv::Mat result_camera_matrix;
+	cv::Mat result_dist_coeffs;
+	double result_rms;
+	size_t result_views;
+	bool result_ready;
+
+	boost::scoped_ptr<boost::thread> worker;
+	boost::mutex mutex;
+	boost::condition_variable job_available;
+	bool stop_flag;
+
+
+	/// Width of the calibrated images.
+	Base::Property<int> prop_width;
+
+	/// Height of the calibrated images.
+	Base::Property<int> prop_height;
+
+	/// Maximal number of kept views.
+	Base::Property<int> prop_max_views;
+
+	/// Minimal number of views required to calibrate.
+	Base::Property<int> prop_min_views;
+
+	/// Minimal distance of view descriptors (see ViewSelector) of a new view.
+	Base::Property<float> prop_min_distance;
+
+	/// Number of accepted views between refinements.
+	Base::Property<int> prop_update_every;
+
+	/// Fix the k3 distortion coefficient to 0.
+	Base::Property<bool> prop_fix_k3;
+
+	/// Assume zero tangential distortion.
+	Base::Property<bool> prop_zero_tangent_dist;
+};
+
+}//: namespace CalibrationAccumulator
+}//: namespace Processors
+
+/*
+ * Register processor component.
+ */
+REGISTER_COMPONENT("CalibrationAccumulator", Processors::CalibrationAccumulator::CalibrationAccumulator)
+
+#endif /* CalibrationAccumulator_HPP_ */
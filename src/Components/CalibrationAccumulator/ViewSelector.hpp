@@ -0,0 +1,232 @@
+/*!
+ * \file ViewSelector.hpp
+ * \brief Bounded set of calibration views, selected by image coverage and pose diversity.
+ */
+
+#ifndef VIEWSELECTOR_HPP_
+#define VIEWSELECTOR_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "Types/Objects3D/ModelPoints.hpp"
+
+namespace Processors {
+namespace CalibrationAccumulator {
+
+/// Number of components of the view descriptor.
+static const int VIEW_DESCRIPTOR_SIZE = 5;
+
+/// Single view of the calibration pattern.
+struct CalibrationView {
+	std::vector<cv::Point2f> image_points;
+	Types::Objects3D::ModelPointsPtr model_points;
+
+	/// Position, scale and perspective distortion of the pattern in the image (see ViewSelector::describe()).
+	float descriptor[VIEW_DESCRIPTOR_SIZE];
+
+	/// Coverage grid cells of the image points.
+	std::vector<int> cells;
+};
+
+/*!
+ * \class ViewSelector
+ * \brief Keeps at most max_views views - the ones which cover the image and differ from each other the most.
+ *
+ * Every view is described by the centroid and scale of its image points and by the anisotropy (with orientation)
+ * of their distribution, which grows with the tilt of the pattern. A view is accepted if it is far enough
+ * from all kept views or covers cells of the image grid not covered so far. When the set is full,
+ * the new view replaces the most redundant one (the one closest to its neighbour) if it is more distinct.
+ * All operations are O(max_views^2) at most, independently of the number of offered views.
+ */
+class ViewSelector {
+public:
+	static const int GRID_COLS = 8;
+	static const int GRID_ROWS = 6;
+
+	ViewSelector() :
+		max_views(40), min_distance(0.05f)
+	{
+		clear();
+	}
+
+	/// Sets parameters, drops the views if the image size changed.
+	void configure(size_t max_views_, float min_distance_, const cv::Size & image_size_) {
+		max_views = std::max<size_t>(max_views_, 1);
+		min_distance = min_distance_;
+		if (image_size_ != image_size) {
+			image_size = image_size_;
+			clear();
+		}//: if
+		while (views.size() > max_views)
+			remove(mostRedundant());
+		views.reserve(max_views);
+	}
+
+	void clear() {
+		views.clear();
+		std::fill(coverage_counts, coverage_counts + GRID_COLS * GRID_ROWS, 0);
+	}
+
+	/*!
+	 * Offers a new view.
+	 * \returns true if the view was added to the set
+	 */
+	bool offer(const std::vector<cv::Point2f> & image_points_, const Types::Objects3D::ModelPointsPtr & model_points_) {
+		if (image_points_.size() < 4 || !model_points_ || model_points_->size() != image_points_.size()
+				|| image_size.area() == 0)
+			return false;
+
+		CalibrationView view;
+		describe(image_points_, view.descriptor);
+		view.cells.resize(image_points_.size());
+		double gain = 0;
+		for (size_t i = 0; i < image_points_.size(); ++i) {
+			view.cells[i] = cell(image_points_[i]);
+			gain += 1.0 / (1 + coverage_counts[view.cells[i]]);
+		}//: for
+		gain /= image_points_.size();
+
+		const float d = nearest(view.descriptor, views.size());
+		// New area of the image or a distinct pose.
+		const bool useful = (d >= min_distance) || (gain >= 0.5);
+		if (!useful)
+			return false;
+
+		if (views.size() >= max_views) {
+			const size_t victim = mostRedundant();
+			if (d <= redundancy(victim))
+				return false;
+			remove(victim);
+		}//: if
+
+		view.image_points = image_points_;
+		view.model_points = model_points_;
+		for (size_t i = 0; i < view.cells.size(); ++i)
+			++coverage_counts[view.cells[i]];
+		views.push_back(view);
+		return true;
+	}
+
+	const std::vector<CalibrationView> & getViews() const {
+		return views;
+	}
+
+	/// Fraction of the image grid cells covered by at least one point.
+	double coverage() const {
+		int covered = 0;
+		for (int i = 0; i < GRID_COLS * GRID_ROWS; ++i)
+			covered += (coverage_counts[i] > 0);
+		return (double) covered / (GRID_COLS * GRID_ROWS);
+	}
+
+private:
+	/// Computes the view descriptor - all components are roughly in [0, 1].
+	void describe(const std::vector<cv::Point2f> & points_, float * descriptor_) const {
+		double mx = 0, my = 0;
+		for (size_t i = 0; i < points_.size(); ++i) {
+			mx += points_[i].x;
+			my += points_[i].y;
+		}//: for
+		mx /= points_.size();
+		my /= points_.size();
+
+		double sxx = 0, syy = 0, sxy = 0;
+		for (size_t i = 0; i < points_.size(); ++i) {
+			const double dx = points_[i].x - mx, dy = points_[i].y - my;
+			sxx += dx * dx;
+			syy += dy * dy;
+			sxy += dx * dy;
+		}//: for
+		sxx /= points_.size();
+		syy /= points_.size();
+		sxy /= points_.size();
+
+		// Eigenvalues of the covariance - anisotropy and its orientation (doubled angle, so the sign does not matter).
+		const double tr = sxx + syy;
+		const double diff = std::sqrt((sxx - syy) * (sxx - syy) + 4 * sxy * sxy);
+		const double anisotropy = (tr > 0) ? diff / tr : 0;
+		const double angle2 = std::atan2(2 * sxy, sxx - syy);
+
+		descriptor_[0] = (float) (mx / image_size.width);
+		descriptor_[1] = (float) (my / image_size.height);
+		descriptor_[2] = (float) (2 * std::sqrt(tr) / std::sqrt((double) image_size.area()));
+		descriptor_[3] = (float) (anisotropy * std::cos(angle2));
+		descriptor_[4] = (float) (anisotropy * std::sin(angle2));
+	}
+
+	int cell(const cv::Point2f & p_) const {
+		int cx = (int) (p_.x * GRID_COLS / image_size.width);
+		int cy = (int) (p_.y * GRID_ROWS / image_size.height);
+		cx = std::min(std::max(cx, 0), GRID_COLS - 1);
+		cy = std::min(std::max(cy, 0), GRID_ROWS - 1);
+		return cy * GRID_COLS + cx;
+	}
+
+	static float distance(const float * a_, const float * b_) {
+		float d = 0;
+		for (int i = 0; i < VIEW_DESCRIPTOR_SIZE; ++i)
+			d += (a_[i] - b_[i]) * (a_[i] - b_[i]);
+		return std::sqrt(d);
+	}
+
+	/// Distance from the descriptor to the nearest kept view (other than the skipped one).
+	float nearest(const float * descriptor_, size_t skip_) const {
+		float best = std::numeric_limits<float>::max();
+		for (size_t i = 0; i < views.size(); ++i)
+			if (i != skip_)
+				best = std::min(best, distance(descriptor_, views[i].descriptor));
+		return best;
+	}
+
+	float redundancy(size_t index_) const {
+		return nearest(views[index_].descriptor, index_);
+	}
+
+	size_t mostRedundant() const {
+		size_t victim = 0;
+		float smallest = std::numeric_limits<float>::max();
+		for (size_t i = 0; i < views.size(); ++i) {
+			const float r = redundancy(i);
+			if (r < smallest) {
+				smallest = r;
+				victim = i;
+			}//: if
+		}//: for
+		return victim;
+	}
+
+	void remove(size_t index_) {
+		const std::vector<int> & cells = views[index_].cells;
+		for (size_t i = 0; i < cells.size(); ++i)
+			--coverage_counts[cells[i]];
+		// Move the last view into the gap without copying its vectors.
+		CalibrationView & last = views.back();
+		if (&views[index_] != &last) {
+			CalibrationView & view = views[index_];
+			view.image_points.swap(last.image_points);
+			view.model_points.swap(last.model_points);
+			view.cells.swap(last.cells);
+			std::copy(last.descriptor, last.descriptor + VIEW_DESCRIPTOR_SIZE, view.descriptor);
+		}//: if
+		views.pop_back();
+	}
+
+	size_t max_views;
+	float min_distance;
+	cv::Size image_size;
+
+	std::vector<CalibrationView> views;
+
+	/// Number of kept points in each cell of the image grid.
+	int coverage_counts[GRID_COLS * GRID_ROWS];
+};
+
+}//: namespace CalibrationAccumulator
+}//: namespace Processors
+
+#endif /* VIEWSELECTOR_HPP_ */
@@ -0,0 +1,110 @@
+/*!
+ * \file CalibrationDatabaseProvider.cpp
+ * \brief Class responsible for publishing camera parameters stored in a calibration database - methods definition.
+ */
+
+#include "CalibrationDatabaseProvider.hpp"
+
+#include <boost/bind.hpp>
+
+namespace Processors {
+namespace CalibrationDatabaseProvider {
+
+CalibrationDatabaseProvider::CalibrationDatabaseProvider(const std::string & n) :
+	Base::Component(n),
+	prop_data_file("data_file", std::string("")),
+	prop_camera_id("camera_id", std::string("")),
+	prop_width("width", 0),
+	prop_height("height", 0)
+{
+	registerProperty(prop_data_file);
+	registerProperty(prop_camera_id);
+	registerProperty(prop_width);
+	registerProperty(prop_height);
+
+	CLOG(LTRACE) << "Constructed";
+}
+
+CalibrationDatabaseProvider::~CalibrationDatabaseProvider() {
+	CLOG(LTRACE) << "Destroyed";
+}
+
+
+void CalibrationDatabaseProvider::prepareInterface() {
+	// Register streams.
+	registerStream("in_camera_id", &in_camera_id);
+	registerStream("out_camera_info", &out_camera_info);
+
+	// Register handlers - publishes the configured camera.
+	registerHandler("generate_data", boost::bind(&CalibrationDatabaseProvider::generate_data, this));
+	addDependency("generate_data", NULL);
+
+	// Register handlers - publishes the requested camera, activated when camera id arrives.
+	registerHandler("onNewCameraId", boost::bind(&CalibrationDatabaseProvider::onNewCameraId, this));
+	addDependency("onNewCameraId", &in_camera_id);
+}
+
+bool CalibrationDatabaseProvider::onInit() {
+	CLOG(LTRACE) << "initialize\n";
+
+	try {
+		database = Types::CalibrationDatabase::shared(prop_data_file);
+		CLOG(LINFO) << "Calibration database " << database->file() << " holds " << database->size() << " calibrations";
+
+		const std::string id = prop_camera_id;
+		if (!id.empty()) {
+			camera_info = database->find(id, prop_width, prop_height);
+			if (!camera_info)
+				CLOG(LWARNING) << "No calibration of camera " << id << " (" << prop_width << "x" << prop_height << ")";
+		}//: if
+	} catch (const std::exception & ex) {
+		CLOG(LERROR) << "Could not open calibration database: " << ex.what();
+		database.reset();
+		return false;
+	}//: catch
+
+	return true;
+}
+
+bool CalibrationDatabaseProvider::onFinish() {
+	CLOG(LTRACE) << "onFinish";
+	camera_info.reset();
+	database.reset();
+	return true;
+}
+
+void CalibrationDatabaseProvider::generate_data() {
+	CLOG(LTRACE) << "generate_data";
+	if (camera_info)
+		out_camera_info.write(*camera_info);
+}
+
+void CalibrationDatabaseProvider::onNewCameraId() {
+	CLOG(LTRACE) << "onNewCameraId";
+	const std::string id = in_camera_id.read();
+	if (!database)
+		return;
+
+	try {
+		Types::CalibrationDatabase::CameraInfoPtr info = database->find(id, prop_width, prop_height);
+		if (!info) {
+			CLOG(LWARNING) << "No calibration of camera " << id;
+			return;
+		}//: if
+		out_camera_info.write(*info);
+	} catch (const std::exception & ex) {
+		CLOG(LERROR) << "CalibrationDatabaseProvider::onNewCameraId() failed: " << ex.what();
+	}//: catch
+}
+
+bool CalibrationDatabaseProvider::onStart() {
+	return true;
+}
+
+bool CalibrationDatabaseProvider::onStop() {
+	return true;
+}
+
+
+}//: namespace CalibrationDatabaseProvider
+}//: namespace Processors
@@ -0,0 +1,119 @@
+/*!
+ * \file CalibrationDatabaseProvider.hpp
+ * \brief Class responsible for publishing camera parameters stored in a calibration database - class declaration.
+ */
+
+
+#ifndef CalibrationDatabaseProvider_HPP_
+#define CalibrationDatabaseProvider_HPP_
+
+#include "Component_Aux.hpp"
+#include "Component.hpp"
+#include "DataStream.hpp"
+#include "Property.hpp"
+
+#include "Types/CameraInfo.hpp"
+#include "Types/CalibrationDatabase.hpp"
+
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+/**
+ * \defgroup CalibrationDatabaseProvider CalibrationDatabaseProvider
+ *
+ * \brief Publishes CameraInfo of cameras stored in a single calibration database file.
+ */
+
+namespace Processors {
+namespace CalibrationDatabaseProvider {
+
+/*!
+ * \class CalibrationDatabaseProvider
+ * \brief Class responsible for publishing camera parameters from a calibration database.
+ *
+ * Counterpart of CameraInfoProvider for multi-camera setups - all calibrations are kept in one file
+ * (see Types::CalibrationDatabase), opened once and shared by all providers using it. Only calibrations
+ * actually requested are decoded. The configured camera is published by generate_data, any other one
+ * is published on demand, when its id arrives on in_camera_id.
+ */
+class CalibrationDatabaseProvider : public Base::Component {
+
+public:
+	/*!
+	 * Constructor. Sets ID and startup variables.
+	 */
+	CalibrationDatabaseProvider(const std::string & name = "CalibrationDatabaseProvider");
+
+	/*!
+	 * Destructor.
+	 */
+	virtual ~CalibrationDatabaseProvider();
+
+	virtual void prepareInterface();
+
+protected:
+
+	/*!
+	 * Opens the database and looks up the configured camera.
+	 */
+	bool onInit();
+
+	/*!
+	 * Releases the database.
+	 */
+	bool onFinish();
+
+	/*!
+	 * Start component
+	 */
+	bool onStart();
+
+	/*!
+	 * Stop component
+	 */
+	bool onStop();
+
+	/// Input data stream - id of the requested camera.
+	Base::DataStreamIn <std::string, Base::DataStreamBuffer::Newest> in_camera_id;
+
+	/// Output data stream - camera parameters.
+	Base::DataStreamOut <Types::CameraInfo> out_camera_info;
+
+	/*!
+	 * Event handler function - publishes parameters of the configured camera.
+	 */
+	void generate_data();
+
+	/*!
+	 * Event handler function - publishes parameters of the requested camera.
+	 */
+	void onNewCameraId();
+
+private:
+	/// Database shared with other providers using the same file.
+	boost::shared_ptr<Types::CalibrationDatabase> database;
+
+	/// Parameters of the configured camera.
+	Types::CalibrationDatabase::CameraInfoPtr camera_info;
+
+	/// Database file.
+	Base::Property<std::string> prop_data_file;
+
+	/// Id of the published camera.
+	Base::Property<std::string> prop_camera_id;
+
+	/// Resolution of the published camera (0 x 0 selects the first one stored).
+	Base::Property<int> prop_width;
+	Base::Property<int> prop_height;
+};
+
+}//: namespace CalibrationDatabaseProvider
+}//: namespace Processors
+
+/*
+ * Register processor component.
+ */
+REGISTER_COMPONENT("CalibrationDatabaseProvider", Processors::CalibrationDatabaseProvider::CalibrationDatabaseProvider)
+
+#endif /* CalibrationDatabaseProvider_HPP_ */
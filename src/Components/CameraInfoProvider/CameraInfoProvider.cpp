@@ -12,6 +12,12 @@
 
 #include <boost/bind.hpp>
 
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
 namespace Processors {
 namespace CameraInfoProvider {
 
@@ -23,7 +29,11 @@ CameraInfoProvider::CameraInfoProvider(const std::string & name) :
 		projection_matrix("projection_matrix", cv::Mat(cv::Mat::zeros(3, 4, CV_32FC1))),
 		rotation_matrix("rotation_matrix", cv::Mat(cv::Mat::eye(3, 3, CV_32FC1))),
 		translation_matrix("translation_matrix", cv::Mat(cv::Mat::zeros(3, 1, CV_32FC1))),
-		data_file("data_file", string(""))
+		data_file("data_file", string("")),
+		watch_file("watch_file", false),
+		shared_name("shared_name", string("")),
+		stats_interval("stats.interval", 0.0),
+		shared(NULL)
 {
 	width.addConstraint("0");
 	width.addConstraint("1280");
@@ -40,6 +50,14 @@ CameraInfoProvider::CameraInfoProvider(const std::string & name) :
 	registerProperty(rotation_matrix);
 	registerProperty(translation_matrix);
 	registerProperty(data_file);
+	registerProperty(watch_file);
+	registerProperty(shared_name);
+	registerProperty(stats_interval);
+
+	stats_generate_data = &stats.add("generate_data");
+	stats_update_params = &stats.add("update_params");
+
+	stop_pipe[0] = stop_pipe[1] = -1;
 }
 
 CameraInfoProvider::~CameraInfoProvider() {
@@ -50,6 +68,7 @@ void CameraInfoProvider::prepareInterface() {
 	// Register data streams.
 	registerStream("out_camera_info", &out_camerainfo);
 	registerStream("in_camera_info", &in_camerainfo);
+	registerStream("out_stats", &out_stats);
 
 	//"Generate data" handler.
 	registerHandler("generate_data", boost::bind(&CameraInfoProvider::generate_data, this));
@@ -67,15 +86,33 @@ void CameraInfoProvider::prepareInterface() {
 }
 
 bool CameraInfoProvider::onInit() {
+	stats.setInterval(stats_interval);
+
+	if (shared_name != "") {
+		shared = &Types::SharedCameraInfo::get(shared_name);
+		if (!shared->attachWriter(this)) {
+			CLOG(LERROR) << "Camera parameters " << shared_name << " are already published by another component";
+			shared = NULL;
+			return false;
+		}
+	}//: if
+
 	if (data_file != "") {
 		CLOG(LINFO) << "reload_file";
 		reload_file();
+		if (watch_file)
+			start_watcher();
 	}
 
 	return true;
 }
 
 bool CameraInfoProvider::onFinish() {
+	stop_watcher();
+	if (shared) {
+		shared->detachWriter(this);
+		shared = NULL;
+	}//: if
 	return true;
 }
 
@@ -88,6 +125,21 @@ bool CameraInfoProvider::onStart() {
 }
 
 void CameraInfoProvider::generate_data() {
+	if (stats.reportDue())
+		publish_stats();
+	Types::HandlerStats::Scope timer(*stats_generate_data);
+
+	// Swap in parameters parsed by the watcher (only the pointer is exchanged under the lock).
+	boost::shared_ptr<CalibrationFile> file;
+	{
+		boost::mutex::scoped_lock lock(pending_mutex);
+		file.swap(pending_file);
+	}
+	if (file) {
+		apply_file(*file);
+		CLOG(LINFO) << "Camera parameters reloaded from " << data_file;
+	}
+
 	CLOG(LDEBUG) << "setWidth";
 	camera_info.setWidth(width);
 	CLOG(LDEBUG) << "setHeight";
@@ -106,9 +158,42 @@ void CameraInfoProvider::generate_data() {
 	camera_info.setTranlationMatrix(translation_matrix);
 	CLOG(LDEBUG) << "write";
 	out_camerainfo.write(camera_info);
+	timer.published();
+
+	if (shared)
+		publish_snapshot();
+}
+
+namespace {
+
+bool sameMat(const cv::Mat & a_, const cv::Mat & b_) {
+	if (a_.size() != b_.size() || a_.type() != b_.type())
+		return false;
+	return a_.empty() || cv::norm(a_, b_, cv::NORM_INF) == 0;
+}
+
+} //: namespace
+
+void CameraInfoProvider::publish_snapshot() {
+	Types::CameraInfoSnapshotPtr last = shared->snapshot();
+	if (last) {
+		const Types::CameraInfo info = last->info();
+		if (info.width() == camera_info.width() && info.height() == camera_info.height()
+				&& sameMat(info.cameraMatrix(), camera_info.cameraMatrix())
+				&& sameMat(info.distCoeffs(), camera_info.distCoeffs())
+				&& sameMat(info.rectificationMatrix(), camera_info.rectificationMatrix())
+				&& sameMat(info.projectionMatrix(), camera_info.projectionMatrix())
+				&& sameMat(info.rotationMatrix(), camera_info.rotationMatrix())
+				&& sameMat(info.translationMatrix(), camera_info.translationMatrix()))
+			return;
+	}
+
+	shared->publish(camera_info);
+	CLOG(LDEBUG) << "Camera parameters published as " << shared_name << " version " << shared->snapshot()->version();
 }
 
 void CameraInfoProvider::update_params() {
+	Types::HandlerStats::Scope timer(*stats_update_params);
 	Types::CameraInfo camera_info = in_camerainfo.read();
 	width = camera_info.width();
 	height = camera_info.height();
@@ -120,47 +205,153 @@ void CameraInfoProvider::update_params() {
 	translation_matrix = camera_info.translationMatrix();
 }
 
+void CameraInfoProvider::publish_stats() {
+	const Types::HandlerStatsReport report = stats.snapshot();
+	for (size_t i = 0; i < report.size(); ++i)
+		CLOG(LINFO) << report[i];
+	out_stats.write(report);
+}
+
 void CameraInfoProvider::reload_file() {
 	CLOG(LDEBUG) << "Loading from " << data_file;
-	cv::FileStorage fs(data_file, cv::FileStorage::READ);
-	cv::Mat oTempMat;
-	try {
-		fs["M"] >> oTempMat;
-		camera_matrix = oTempMat;
-	} catch (...) {
-		CLOG(LWARNING) << "No camera matrix in " << data_file;
+	CalibrationFile file;
+	if (!file.load(data_file)) {
+		CLOG(LWARNING) << "Could not read " << data_file;
+		return;
 	}
-	try {
-		fs["D"] >> oTempMat;
-		dist_coeffs = oTempMat;
-	} catch (...) {
+	apply_file(file);
+}
+
+void CameraInfoProvider::apply_file(const CalibrationFile & file_) {
+	if (!file_.camera_matrix.empty())
+		camera_matrix = file_.camera_matrix;
+	else
+		CLOG(LWARNING) << "No camera matrix in " << data_file;
+	if (!file_.dist_coeffs.empty())
+		dist_coeffs = file_.dist_coeffs;
+	else
 		CLOG(LWARNING) << "No distortion coefficients in " << data_file;
-	}
-	try {
-		fs["R"] >> oTempMat;
-		rectificaton_matrix = oTempMat;
-	} catch (...) {
+	if (!file_.rectification_matrix.empty())
+		rectificaton_matrix = file_.rectification_matrix;
+	else
 		CLOG(LWARNING) << "No rectificaton matrix in " << data_file;
-	}
-	try {
-		fs["P"] >> oTempMat;
-		projection_matrix = oTempMat;
-	} catch (...) {
+	if (!file_.projection_matrix.empty())
+		projection_matrix = file_.projection_matrix;
+	else
 		CLOG(LWARNING) << "No projection matrix in " << data_file;
-	}
-	try {
-		fs["ROT"] >> oTempMat;
-		rotation_matrix = oTempMat;
-	} catch (...) {
+	if (!file_.rotation_matrix.empty())
+		rotation_matrix = file_.rotation_matrix;
+	else
 		CLOG(LWARNING) << "No rotation matrix in " << data_file;
-	}
+	if (!file_.translation_matrix.empty())
+		translation_matrix = file_.translation_matrix;
+	else
+		CLOG(LWARNING) << "No translation matrix in " << data_file;
+}
+
+bool CalibrationFile::load(const std::string & filename_) {
 	try {
-		fs["T"] >> oTempMat;
-		translation_matrix = oTempMat;
+		cv::FileStorage fs(filename_, cv::FileStorage::READ);
+		if (!fs.isOpened())
+			return false;
+		fs["M"] >> camera_matrix;
+		fs["D"] >> dist_coeffs;
+		fs["R"] >> rectification_matrix;
+		fs["P"] >> projection_matrix;
+		fs["ROT"] >> rotation_matrix;
+		fs["T"] >> translation_matrix;
+		fs.release();
 	} catch (...) {
-		CLOG(LWARNING) << "No translation matrix in " << data_file;
+		// Malformed (e.g. partially written) file.
+		return false;
+	}
+	return true;
+}
+
+void CameraInfoProvider::start_watcher() {
+#ifdef __linux__
+	if (pipe(stop_pipe) != 0) {
+		CLOG(LERROR) << "Could not create the watcher pipe, " << data_file << " will not be watched";
+		stop_pipe[0] = stop_pipe[1] = -1;
+		return;
+	}
+	watcher.reset(new boost::thread(boost::bind(&CameraInfoProvider::watcher_loop, this, std::string(data_file))));
+#else
+	CLOG(LWARNING) << "Watching files is not supported on this platform";
+#endif
+}
+
+void CameraInfoProvider::stop_watcher() {
+#ifdef __linux__
+	if (watcher) {
+		if (write(stop_pipe[1], "x", 1) != 1)
+			CLOG(LWARNING) << "Could not wake the watcher up";
+		watcher->join();
+		watcher.reset();
 	}
-	fs.release();
+	for (int i = 0; i < 2; ++i) {
+		if (stop_pipe[i] >= 0)
+			close(stop_pipe[i]);
+		stop_pipe[i] = -1;
+	}
+#endif
+}
+
+void CameraInfoProvider::watcher_loop(std::string filename_) {
+#ifdef __linux__
+	// Watch the directory - editors and tools often replace the file instead of rewriting it.
+	const size_t slash = filename_.rfind('/');
+	const std::string dir = (slash == std::string::npos) ? std::string(".") : filename_.substr(0, slash + 1);
+	const std::string name = (slash == std::string::npos) ? filename_ : filename_.substr(slash + 1);
+
+	const int fd = inotify_init();
+	if (fd < 0) {
+		CLOG(LERROR) << "inotify_init failed, " << filename_ << " will not be watched";
+		return;
+	}
+	if (inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		CLOG(LERROR) << "Could not watch " << dir;
+		close(fd);
+		return;
+	}
+	CLOG(LINFO) << "Watching " << filename_;
+
+	char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	for (;;) {
+		pollfd fds[2];
+		fds[0].fd = fd;
+		fds[0].events = POLLIN;
+		fds[1].fd = stop_pipe[0];
+		fds[1].events = POLLIN;
+		if (poll(fds, 2, -1) < 0)
+			continue;
+		if (fds[1].revents)
+			break;
+
+		const ssize_t len = read(fd, buffer, sizeof(buffer));
+		bool changed = false;
+		for (ssize_t i = 0; i < len; ) {
+			const inotify_event * event = reinterpret_cast<const inotify_event *>(buffer + i);
+			if (event->len && name == event->name)
+				changed = true;
+			i += sizeof(inotify_event) + event->len;
+		}
+		if (!changed)
+			continue;
+
+		// Parse here, off the executor thread.
+		boost::shared_ptr<CalibrationFile> file(new CalibrationFile);
+		if (!file->load(filename_)) {
+			CLOG(LWARNING) << "Could not read " << filename_ << ", previous parameters kept";
+			continue;
+		}
+		CLOG(LDEBUG) << filename_ << " changed";
+		boost::mutex::scoped_lock lock(pending_mutex);
+		pending_file = file;
+	}
+
+	close(fd);
+#endif
 }
 
 } //: namespace CameraInfoProvider
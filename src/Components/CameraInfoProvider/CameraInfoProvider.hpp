@@ -14,16 +14,52 @@
 #include "EventHandler2.hpp"
 
 #include <Types/CameraInfo.hpp>
+#include <Types/CameraInfoSnapshot.hpp>
+#include <Types/HandlerStats.hpp>
 #include <Types/MatrixTranslator.hpp>
 
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
 namespace Processors {
 namespace CameraInfoProvider {
 
+/*!
+ * \struct CalibrationFile
+ * \brief Camera parameters read from a calibration file (matrices missing in the file are left empty).
+ */
+struct CalibrationFile {
+	cv::Mat camera_matrix;
+	cv::Mat dist_coeffs;
+	cv::Mat rectification_matrix;
+	cv::Mat projection_matrix;
+	cv::Mat rotation_matrix;
+	cv::Mat translation_matrix;
+
+	/*!
+	 * Reads the file.
+	 * \returns false if the file could not be opened or parsed
+	 */
+	bool load(const std::string & filename_);
+};
+
 /*!
  * \class CameraInfoProvider
  * \brief CameraInfoProvider processor class.
  *
  * Emits CameraInfo messages
+ *
+ * Parameters can be loaded from data_file. In the watch mode (watch_file) a background thread watches the file
+ * (with inotify) and parses it whenever it is rewritten or replaced - new parameters are swapped in
+ * by the next generate_data, so recalibrations reach running tasks without blocking the executor.
+ *
+ * If shared_name is set, every change of the parameters is also published as a snapshot in the
+ * Types::SharedCameraInfo holder of that name, readable from any thread of the process. Only one component
+ * may publish under a given name - initialization of the second one fails.
+ *
+ * Durations of generate_data and update_params are always measured; they are logged and written to out_stats
+ * every stats.interval seconds (0 - default - no reports).
  */
 class CameraInfoProvider: public Base::Component {
 public:
@@ -71,6 +107,8 @@ protected:
 
 	Base::DataStreamIn<Types::CameraInfo> in_camerainfo;
 
+	Base::DataStreamOut<Types::HandlerStatsReport> out_stats;
+
 	// Handlers
 	Base::EventHandler2 h_generate_data;
 	Base::EventHandler2 h_update_params;
@@ -81,6 +119,22 @@ protected:
 	void update_params();
 	void reload_file();
 
+	/// Copies parameters read from the file into the properties.
+	void apply_file(const CalibrationFile & file_);
+
+	/// Watcher thread - parses the file whenever it changes.
+	void watcher_loop(std::string filename_);
+
+	/// Logs and publishes statistics of the handlers.
+	void publish_stats();
+
+	/// Publishes the parameters to the shared holder if they changed since the last publication.
+	void publish_snapshot();
+
+	/// Starts/stops the watcher thread.
+	void start_watcher();
+	void stop_watcher();
+
 	Base::Property<int> width;
 	Base::Property<int> height;
 	Base::Property<cv::Mat, Types::MatrixTranslator> camera_matrix;
@@ -90,8 +144,28 @@ protected:
 	Base::Property<cv::Mat, Types::MatrixTranslator> rotation_matrix;
 	Base::Property<cv::Mat, Types::MatrixTranslator> translation_matrix;
 	Base::Property<string> data_file;
+	Base::Property<bool> watch_file;
+	Base::Property<string> shared_name;
+	Base::Property<double> stats_interval;
 	Types::CameraInfo camera_info;
 
+	/// Parameters parsed by the watcher, not applied yet.
+	boost::shared_ptr<CalibrationFile> pending_file;
+	boost::mutex pending_mutex;
+
+	/// Statistics of the handlers.
+	Types::HandlerStatsGroup stats;
+	Types::HandlerStats * stats_generate_data;
+	Types::HandlerStats * stats_update_params;
+
+	/// Holder of the published snapshots (NULL if shared_name is empty).
+	Types::SharedCameraInfo * shared;
+
+	boost::scoped_ptr<boost::thread> watcher;
+
+	/// Pipe waking the watcher up when it should stop.
+	int stop_pipe[2];
+
 };
 
 } //: namespace CameraInfoProvider
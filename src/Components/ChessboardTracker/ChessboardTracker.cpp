@@ -0,0 +1,293 @@
+/*!
+ * \file ChessboardTracker.cpp
+ * \brief Class responsible for incremental tracking of chessboards and circle grids - methods definition.
+ */
+
+#include "ChessboardTracker.hpp"
+
+#include <cmath>
+
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/calib3d/calib3d.hpp>
+#include <opencv2/video/tracking.hpp>
+
+namespace Processors {
+namespace ChessboardTracker {
+
+ChessboardTracker::ChessboardTracker(const std::string & n) :
+	Base::Component(n),
+	prop_pattern("pattern.type", std::string("chessboard")),
+	prop_width("pattern.width", 9),
+	prop_height("pattern.height", 6),
+	prop_square_size("pattern.square_size", 1.0f),
+	prop_roi_margin("tracking.roi_margin", 32),
+	prop_window("tracking.window", 15),
+	prop_levels("tracking.levels", 2),
+	prop_topology_tolerance("tracking.topology_tolerance", 0.25f),
+	prop_subpix("tracking.subpix", true),
+	prop_stats_interval("stats.interval", 0.0)
+{
+	registerProperty(prop_pattern);
+	registerProperty(prop_width);
+	registerProperty(prop_height);
+	registerProperty(prop_square_size);
+	registerProperty(prop_roi_margin);
+	registerProperty(prop_window);
+	registerProperty(prop_levels);
+	registerProperty(prop_topology_tolerance);
+	registerProperty(prop_subpix);
+	registerProperty(prop_stats_interval);
+
+	CLOG(LTRACE) << "Constructed";
+}
+
+ChessboardTracker::~ChessboardTracker() {
+	CLOG(LTRACE) << "Destroyed";
+}
+
+
+void ChessboardTracker::prepareInterface() {
+	// Register streams.
+	registerStream("in_img", &in_img);
+	registerStream("out_chessboard", &out_chessboard);
+	registerStream("out_gridpattern", &out_gridpattern);
+	registerStream("out_pattern_found", &out_pattern_found);
+	registerStream("out_pattern_not_found", &out_pattern_not_found);
+	registerStream("out_fallback_rate", &out_fallback_rate);
+
+	// Register handlers - tracks the pattern, activated when new image arrives.
+	registerHandler("onNewImage", boost::bind(&ChessboardTracker::onNewImage, this));
+	addDependency("onNewImage", &in_img);
+
+	// Register handlers - forces the full detection, triggered manually.
+	registerHandler("Reset", boost::bind(&ChessboardTracker::onReset, this));
+}
+
+bool ChessboardTracker::onInit() {
+	CLOG(LTRACE) << "initialize\n";
+
+	const std::string type = prop_pattern;
+	Types::Objects3D::ModelPoints::Layout layout;
+	if (type == "symmetric_grid") {
+		pattern = SYMMETRIC_GRID;
+		layout = Types::Objects3D::ModelPoints::SYMMETRIC_GRID;
+	} else if (type == "asymmetric_grid") {
+		pattern = ASYMMETRIC_GRID;
+		layout = Types::Objects3D::ModelPoints::ASYMMETRIC_GRID;
+	} else {
+		if (type != "chessboard")
+			CLOG(LWARNING) << "Unknown pattern type " << type << ", chessboard used instead";
+		pattern = CHESSBOARD;
+		layout = Types::Objects3D::ModelPoints::CHESSBOARD;
+	}//: else
+
+	pattern_size = cv::Size(prop_width, prop_height);
+	if (pattern == CHESSBOARD)
+		chessboard.reset(new Types::Objects3D::Chessboard(pattern_size, prop_square_size));
+	else
+		gridpattern.reset(new Types::Objects3D::GridPattern(pattern_size, prop_square_size, layout));
+
+	tracking = false;
+	stats_frames = stats_fallbacks = stats_lost = 0;
+	stats.setInterval(prop_stats_interval);
+
+	return true;
+}
+
+bool ChessboardTracker::onFinish() {
+	CLOG(LTRACE) << "onFinish";
+	tracking = false;
+	gray.release();
+	prev_gray.release();
+	return true;
+}
+
+void ChessboardTracker::onNewImage() {
+	CLOG(LTRACE) << "onNewImage";
+
+	try {
+		cv::Mat img = in_img.read();
+		if (img.channels() == 3)
+			cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
+		else if (img.channels() == 4)
+			cv::cvtColor(img, gray, cv::COLOR_BGRA2GRAY);
+		else
+			img.copyTo(gray);
+
+		const int64 start = cv::getTickCount();
+		bool found = false;
+		bool fallback = false;
+		if (tracking && prev_gray.size() == gray.size()) {
+			found = track();
+			if (!found) {
+				CLOG(LDEBUG) << "Pattern lost";
+				++stats_lost;
+			}//: if
+		}//: if
+		if (!found) {
+			fallback = true;
+			found = detect();
+		}//: if
+		CLOG(LDEBUG) << (fallback ? "Detection" : "Tracking") << (found ? " succeeded" : " failed") << " in "
+				<< 1000.0 * (cv::getTickCount() - start) / cv::getTickFrequency() << " ms";
+
+		tracking = found;
+		updateStats(fallback);
+		cv::swap(gray, prev_gray);
+
+		if (!found) {
+			out_pattern_not_found.write(Base::UnitType());
+			return;
+		}//: if
+
+		if (chessboard) {
+			chessboard->setImagePoints(points);
+			out_chessboard.write(*chessboard);
+		} else {
+			gridpattern->setImagePoints(points);
+			out_gridpattern.write(*gridpattern);
+		}//: else
+		out_pattern_found.write(Base::UnitType());
+	} catch (const std::exception & ex) {
+		CLOG(LERROR) << "ChessboardTracker::onNewImage() failed: " << ex.what();
+		tracking = false;
+	}//: catch
+}
+
+void ChessboardTracker::onReset() {
+	CLOG(LDEBUG) << "onReset";
+	tracking = false;
+}
+
+bool ChessboardTracker::track() {
+	// Predicted region - previous points and the points moved by the last motion, enlarged by the margin.
+	const int margin = prop_roi_margin + prop_window;
+	cv::Rect roi = cv::boundingRect(points);
+	roi |= roi + cv::Point(cvRound(motion.x), cvRound(motion.y));
+	roi = cv::Rect(roi.x - margin, roi.y - margin, roi.width + 2 * margin, roi.height + 2 * margin)
+			& cv::Rect(0, 0, gray.cols, gray.rows);
+	if (roi.area() == 0)
+		return false;
+
+	const cv::Point2f tl((float) roi.x, (float) roi.y);
+	roi_prev.resize(points.size());
+	roi_next.resize(points.size());
+	for (size_t i = 0; i < points.size(); ++i) {
+		roi_prev[i] = points[i] - tl;
+		roi_next[i] = roi_prev[i] + motion;
+	}//: for
+
+	cv::calcOpticalFlowPyrLK(prev_gray(roi), gray(roi), roi_prev, roi_next, status, error,
+			cv::Size(prop_window, prop_window), prop_levels,
+			cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 20, 0.03), cv::OPTFLOW_USE_INITIAL_FLOW);
+
+	cv::Point2f sum(0, 0);
+	for (size_t i = 0; i < points.size(); ++i) {
+		if (!status[i])
+			return false;
+		const cv::Point2f p = roi_next[i] + tl;
+		if (p.x < 0 || p.y < 0 || p.x >= gray.cols || p.y >= gray.rows)
+			return false;
+		sum += p - points[i];
+		roi_next[i] = p;
+	}//: for
+
+	if (pattern == CHESSBOARD && prop_subpix)
+		cv::cornerSubPix(gray, roi_next, cv::Size(5, 5), cv::Size(-1, -1),
+				cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 10, 0.01));
+
+	if (!checkTopology(roi_next))
+		return false;
+
+	motion = sum * (1.0f / points.size());
+	points.swap(roi_next);
+	return true;
+}
+
+bool ChessboardTracker::detect() {
+	bool found;
+	if (pattern == CHESSBOARD) {
+		found = cv::findChessboardCorners(gray, pattern_size, points,
+				cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_NORMALIZE_IMAGE | cv::CALIB_CB_FAST_CHECK);
+		if (found)
+			cv::cornerSubPix(gray, points, cv::Size(11, 11), cv::Size(-1, -1),
+					cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 30, 0.1));
+	} else {
+		found = cv::findCirclesGrid(gray, pattern_size, points,
+				pattern == ASYMMETRIC_GRID ? cv::CALIB_CB_ASYMMETRIC_GRID : cv::CALIB_CB_SYMMETRIC_GRID);
+	}//: else
+
+	motion = cv::Point2f(0, 0);
+	return found && points.size() == (size_t) pattern_size.area();
+}
+
+bool ChessboardTracker::checkTopology(const std::vector<cv::Point2f> & points_) const {
+	const int w = pattern_size.width, h = pattern_size.height;
+	if (points_.size() != (size_t) w * h)
+		return false;
+
+	const float tol = prop_topology_tolerance;
+	// Rows of the asymmetric grid are shifted by half of the spacing - points of a column line up every other row.
+	const int d = (pattern == ASYMMETRIC_GRID) ? 2 : 1;
+	// Points must be evenly spaced along rows and columns - second differences small relative to the spacing.
+	for (int i = 0; i < h; ++i) {
+		for (int j = 0; j < w; ++j) {
+			const cv::Point2f & p = points_[i * w + j];
+			if (j > 0 && j + 1 < w) {
+				const cv::Point2f & a = points_[i * w + j - 1], & b = points_[i * w + j + 1];
+				if (cv::norm(a + b - 2.0f * p) > tol * 0.5 * cv::norm(b - a))
+					return false;
+			}//: if
+			if (i >= d && i + d < h) {
+				const cv::Point2f & a = points_[(i - d) * w + j], & b = points_[(i + d) * w + j];
+				if (cv::norm(a + b - 2.0f * p) > tol * 0.5 * cv::norm(b - a))
+					return false;
+			}//: if
+		}//: for
+	}//: for
+
+	// All cells must keep the orientation (no flips, no collapsed cells).
+	float orientation = 0;
+	for (int i = 0; i + 1 < h; ++i) {
+		for (int j = 0; j + 1 < w; ++j) {
+			const cv::Point2f & p = points_[i * w + j];
+			const cv::Point2f r = points_[i * w + j + 1] - p, c = points_[(i + 1) * w + j] - p;
+			const float cross = r.x * c.y - r.y * c.x;
+			if (orientation == 0)
+				orientation = (cross > 0) ? 1.0f : -1.0f;
+			if (cross * orientation <= 0)
+				return false;
+		}//: for
+	}//: for
+	return true;
+}
+
+void ChessboardTracker::updateStats(bool fallback_) {
+	if (prop_stats_interval <= 0)
+		return;
+
+	++stats_frames;
+	if (fallback_)
+		++stats_fallbacks;
+
+	if (!stats.reportDue())
+		return;
+
+	const double rate = (double) stats_fallbacks / stats_frames;
+	CLOG(LINFO) << "Fallback rate " << rate * 100 << "% (" << stats_fallbacks << " detections, "
+			<< stats_lost << " losses in " << stats_frames << " frames)";
+	out_fallback_rate.write(rate);
+	stats_frames = stats_fallbacks = stats_lost = 0;
+}
+
+bool ChessboardTracker::onStart() {
+	return true;
+}
+
+bool ChessboardTracker::onStop() {
+	return true;
+}
+
+
+}//: namespace ChessboardTracker
+}//: namespace Processors
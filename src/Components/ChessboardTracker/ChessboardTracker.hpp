@@ -0,0 +1,212 @@
+/*!
+ * \file ChessboardTracker.hpp
+ * \brief Class responsible for incremental tracking of chessboards and circle grids - class declaration.
+ */
+
+
+#ifndef ChessboardTracker_HPP_
+#define ChessboardTracker_HPP_
+
+#include "Component_Aux.hpp"
+#include "Component.hpp"
+#include "DataStream.hpp"
+#include "Property.hpp"
+
+#include "Types/HandlerStats.hpp"
+#include "Types/Objects3D/Chessboard.hpp"
+#include "Types/Objects3D/GridPattern.hpp"
+
+#include <string>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * \defgroup ChessboardTracker ChessboardTracker
+ *
+ * \brief Tracks a chessboard (or a circle grid) between frames, running the full detection only when the pattern is lost.
+ */
+
+namespace Processors {
+namespace ChessboardTracker {
+
+/*!
+ * \class ChessboardTracker
+ * \brief Class responsible for tracking calibration patterns.
+ *
+ * Once the pattern is detected, its points are tracked with pyramidal Lucas-Kanade optical flow, restricted
+ * to the region predicted from the previous frame (bounding box of the points moved by the last motion,
+ * enlarged by a margin). Tracked points are accepted only if all of them were found and the grid topology
+ * is preserved - neighbouring points stay evenly spaced along rows and columns and no cell is flipped.
+ * Otherwise (and before the first detection) the full detection (cv::findChessboardCorners or cv::findCirclesGrid)
+ * is run on the whole frame.
+ *
+ * The share of frames which needed the full detection (fallback rate) is published and logged
+ * every stats.interval seconds (0 - default - no reports).
+ */
+class ChessboardTracker : public Base::Component {
+
+public:
+	/*!
+	 * Constructor. Sets ID and startup variables.
+	 */
+	ChessboardTracker(const std::string & name = "ChessboardTracker");
+
+	/*!
+	 * Destructor.
+	 */
+	virtual ~ChessboardTracker();
+
+	virtual void prepareInterface();
+
+protected:
+
+	/*!
+	 * Creates the pattern object.
+	 */
+	bool onInit();
+
+	/*!
+	 * Releases the tracking state.
+	 */
+	bool onFinish();
+
+	/*!
+	 * Start component
+	 */
+	bool onStart();
+
+	/*!
+	 * Stop component
+	 */
+	bool onStop();
+
+	/// Input image.
+	Base::DataStreamIn <cv::Mat, Base::DataStreamBuffer::Newest> in_img;
+
+	/// Found chessboard (pattern "chessboard").
+	Base::DataStreamOut <Types::Objects3D::Chessboard> out_chessboard;
+
+	/// Found grid (patterns "symmetric_grid" and "asymmetric_grid").
+	Base::DataStreamOut <Types::Objects3D::GridPattern> out_gridpattern;
+
+	/// Output event - pattern found (detected or tracked).
+	Base::DataStreamOut <Base::UnitType> out_pattern_found;
+
+	/// Output event - pattern not found.
+	Base::DataStreamOut <Base::UnitType> out_pattern_not_found;
+
+	/// Share of frames processed with the full detection during the last statistics period.
+	Base::DataStreamOut <double> out_fallback_rate;
+
+	/*!
+	 * Event handler function - tracks or detects the pattern in the new image.
+	 */
+	void onNewImage();
+
+	/*!
+	 * Event handler function - drops the tracking state, so the pattern is detected in the next frame.
+	 */
+	void onReset();
+
+private:
+	/*!
+	 * Tracks points of the previous frame into the current one, returns false if the pattern was lost.
+	 */
+	bool track();
+
+	/*!
+	 * Runs the full detection on the current frame.
+	 */
+	bool detect();
+
+	/*!
+	 * Checks whether points form a regular grid of the pattern size.
+	 */
+	bool checkTopology(const std::vector<cv::Point2f> & points_) const;
+
+	/*!
+	 * Updates and, at the end of the statistics period, publishes the fallback rate.
+	 */
+	void updateStats(bool fallback_);
+
+	/// Pattern type read from the property.
+	enum Pattern {
+		CHESSBOARD,
+		SYMMETRIC_GRID,
+		ASYMMETRIC_GRID
+	};
+
+	Pattern pattern;
+	cv::Size pattern_size;
+
+	/// Published objects (model points are shared with the ModelPoints cache).
+	boost::scoped_ptr<Types::Objects3D::Chessboard> chessboard;
+	boost::scoped_ptr<Types::Objects3D::GridPattern> gridpattern;
+
+	/// Current and previous frame (grayscale), buffers are reused.
+	cv::Mat gray;
+	cv::Mat prev_gray;
+
+	/// Points found in the previous frame and their motion since the frame before.
+	std::vector<cv::Point2f> points;
+	cv::Point2f motion;
+	bool tracking;
+
+	/// Buffers of the tracker.
+	std::vector<cv::Point2f> roi_prev;
+	std::vector<cv::Point2f> roi_next;
+	std::vector<uchar> status;
+	std::vector<float> error;
+
+	/// Statistics of the current period.
+	int stats_frames;
+	int stats_fallbacks;
+	int stats_lost;
+
+	/// Clock of the statistics period.
+	Types::HandlerStatsGroup stats;
+
+
+	/// Pattern type: chessboard, symmetric_grid or asymmetric_grid.
+	Base::Property<std::string> prop_pattern;
+
+	/// Number of inner corners (circles) per row.
+	Base::Property<int> prop_width;
+
+	/// Number of inner corners (circles) per column.
+	Base::Property<int> prop_height;
+
+	/// Size of a chessboard square (distance between circles).
+	Base::Property<float> prop_square_size;
+
+	/// Margin (in pixels) added to the predicted region of the pattern.
+	Base::Property<int> prop_roi_margin;
+
+	/// Size of the optical flow search window.
+	Base::Property<int> prop_window;
+
+	/// Number of pyramid levels used by the optical flow.
+	Base::Property<int> prop_levels;
+
+	/// Allowed deviation of the grid from a regular one, relative to the local spacing.
+	Base::Property<float> prop_topology_tolerance;
+
+	/// Refine tracked chessboard corners with cv::cornerSubPix.
+	Base::Property<bool> prop_subpix;
+
+	/// Statistics period [s], 0 disables the reports.
+	Base::Property<double> prop_stats_interval;
+};
+
+}//: namespace ChessboardTracker
+}//: namespace Processors
+
+/*
+ * Register processor component.
+ */
+REGISTER_COMPONENT("ChessboardTracker", Processors::ChessboardTracker::ChessboardTracker)
+
+#endif /* ChessboardTracker_HPP_ */
@@ -8,6 +8,7 @@
 #include "HomogenousMatrixProvider.hpp"
 #include "Logger.hpp"
 
+#include <cmath>
 #include <sstream>
 #include "Property.hpp"
 #include <boost/foreach.hpp>
@@ -28,7 +29,14 @@ HomogenousMatrixProvider::HomogenousMatrixProvider(const std::string & n) :
 	prop_z("offset.z", 0),
 	prop_roll("offset.roll", 0),
 	prop_pitch("offset.pitch", 0),
-	prop_yaw("offset.yaw", 0)
+	prop_yaw("offset.yaw", 0),
+	prop_mode("mode", std::string("static")),
+	prop_time_step("motion.time_step", 0.04),
+	prop_velocity("motion.velocity", cv::Mat(cv::Mat::zeros(1, 6, CV_32FC1))),
+	prop_amplitude("motion.amplitude", cv::Mat(cv::Mat::zeros(1, 6, CV_32FC1))),
+	prop_frequency("motion.frequency", 1.0),
+	prop_table("motion.table", cv::Mat(cv::Mat::zeros(1, 6, CV_32FC1))),
+	prop_stats_interval("stats.interval", 0.0)
 	{
 		registerProperty(prop_x);
 		registerProperty(prop_y);
@@ -36,6 +44,15 @@ HomogenousMatrixProvider::HomogenousMatrixProvider(const std::string & n) :
 		registerProperty(prop_roll);
 		registerProperty(prop_pitch);
 		registerProperty(prop_yaw);
+		registerProperty(prop_mode);
+		registerProperty(prop_time_step);
+		registerProperty(prop_velocity);
+		registerProperty(prop_amplitude);
+		registerProperty(prop_frequency);
+		registerProperty(prop_table);
+		registerProperty(prop_stats_interval);
+
+		stats_generate = &stats.add("generateHomogenousMatrix");
 }
 
 HomogenousMatrixProvider::~HomogenousMatrixProvider()
@@ -45,10 +62,14 @@ HomogenousMatrixProvider::~HomogenousMatrixProvider()
 void HomogenousMatrixProvider::prepareInterface() {
 	// Register the output stream.
 	registerStream("out_homogMatrix", &out_homogMatrix);
+	registerStream("out_stats", &out_stats);
 
 	// Register the default handler, activated in every step.
 	registerHandler("generateHomogenousMatrix", boost::bind(&HomogenousMatrixProvider::generateHomogenousMatrix,this));
 	addDependency("generateHomogenousMatrix", NULL);
+
+	// Register handlers - restarts the motion, triggered manually.
+	registerHandler("Reset", boost::bind(&HomogenousMatrixProvider::onReset, this));
 }
 
 bool HomogenousMatrixProvider::onStart()
@@ -67,6 +88,23 @@ bool HomogenousMatrixProvider::onInit()
 {
 	LOG(LTRACE) << "onInit()";
 
+	const std::string m = prop_mode;
+	if (m == "linear")
+		mode = LINEAR;
+	else if (m == "sinusoidal")
+		mode = SINUSOIDAL;
+	else if (m == "table")
+		mode = TABLE;
+	else {
+		if (m != "static")
+			CLOG(LWARNING) << "Unknown mode " << m << ", static used instead";
+		mode = STATIC;
+	}
+
+	step = 0;
+	published = false;
+
+	stats.setInterval(prop_stats_interval);
 
 	return true;
 }
@@ -87,64 +125,76 @@ void HomogenousMatrixProvider::generateHomogenousMatrix()
 {
 	CLOG(LTRACE) << "generateHomogenousMatrix()";
 
-//	Mat_<double> rvec;
-//	Mat_<double> tvec;
+	if (stats.reportDue())
+		publishStats();
+	Types::HandlerStats::Scope timer(*stats_generate);
 
-	// Create homogenous matrix.
-//    Mat_<double> rotationMatrix (3,3);
-    //Rodrigues(rvec, rotationMatrix);
-/*
-	// Roll - rotation around the X (blue) axis.
-	cv::Matx44d roll;
-	roll <<
-		1,          0,           0, 0,
-		0, cos(prop_roll), -sin(prop_roll), 0,
-		0, sin(prop_roll),  cos(prop_roll), 0,
-		0, 0, 0, 1 ;
-
-	CLOG(LDEBUG) << "roll (Matx44d):\n" << roll;
-
-	// Pitch - rotation around the Y (green) axis.
-	cv::Matx44d pitch;
-	pitch <<
-		cos(prop_pitch), 0, sin(prop_pitch), 0,
-		0, 1, 0, 0,
-		-sin(prop_pitch),  0,	cos(prop_pitch), 0,
-		0, 0, 0, 1 ;
-	CLOG(LDEBUG) << "pitch (Matx44d):\n" << pitch;
-
-	// Yaw - rotation around the Z (red) axis.
-	cv::Matx44d yaw;
-	yaw <<
-		cos(prop_yaw), -sin(prop_yaw), 0, 0,
-		sin(prop_yaw),  cos(prop_yaw), 0, 0,
-		0, 0, 1, 0,
-		0, 0, 0, 1;
-	CLOG(LDEBUG) << "yaw (Matx44d):\n" << yaw;
-
-	// translation
-	cv::Matx44d t;
-	t <<
-		0, 0, 0, prop_x,
-		0, 0, 0, prop_y,
-		0, 0, 0, prop_z,
-		0, 0, 0, 0;
-	CLOG(LDEBUG) << "trans (Matx44d):\n" << t;
-
-	// Build the whole transform.
-	cv::Matx44d outputMatrix = t + yaw * pitch * roll;
-
-
-	CLOG(LDEBUG) << "output (Matx44d):\n" << outputMatrix;
-*/
-	// Create matrix from XYZ and RPY angles.
+	const cv::Vec6d off = offset();
 	HomogMatrix hm;
-	hm.setFromXYZRPY(prop_x, prop_y, prop_z, prop_roll, prop_pitch, prop_yaw);
 
-	// Debug: display created matrix.
-	CLOG(LDEBUG) << "HM (HomogMatrix):\n" << hm;
+	if (mode == STATIC) {
+		// Pose changes only with the properties - nothing to do if they are the same.
+		if (published && off == published_offset)
+			return;
+		hm.setFromXYZRPY(off);
+		published_offset = off;
+		published = true;
+
+		// Debug: display created matrix.
+		CLOG(LDEBUG) << "HM (HomogMatrix):\n" << hm;
+	} else {
+		hm.setFromXYZRPY(off + motion(step++));
+	}
 
 	out_homogMatrix.write(hm);
+	timer.published();
+}
+
+void HomogenousMatrixProvider::publishStats()
+{
+	const Types::HandlerStatsReport report = stats.snapshot();
+	for (size_t i = 0; i < report.size(); ++i)
+		CLOG(LINFO) << report[i];
+	out_stats.write(report);
+}
+
+void HomogenousMatrixProvider::onReset()
+{
+	CLOG(LDEBUG) << "onReset()";
+	step = 0;
+	published = false;
+}
+
+cv::Vec6d HomogenousMatrixProvider::offset() const
+{
+	return cv::Vec6d(prop_x, prop_y, prop_z, prop_roll, prop_pitch, prop_yaw);
+}
+
+cv::Vec6d HomogenousMatrixProvider::motion(unsigned long step_) const
+{
+	const double t = step_ * prop_time_step;
+	switch (mode) {
+	case LINEAR:
+		return readVector(prop_velocity) * t;
+	case SINUSOIDAL:
+		return readVector(prop_amplitude) * std::sin(2 * M_PI * prop_frequency * t);
+	case TABLE: {
+		const cv::Mat table = prop_table;
+		if (table.rows == 0)
+			return cv::Vec6d();
+		return readVector(table, step_ % table.rows);
+	}
+	default:
+		return cv::Vec6d();
+	}
+}
+
+cv::Vec6d HomogenousMatrixProvider::readVector(const cv::Mat & mat_, int row_)
+{
+	cv::Vec6d v;
+	for (int i = 0; i < 6 && i < mat_.cols; ++i)
+		v[i] = mat_.at<float>(row_, i);
+	return v;
 }
 
 } // namespace HomogenousMatrixProvider
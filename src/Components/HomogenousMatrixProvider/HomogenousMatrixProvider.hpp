@@ -15,6 +15,8 @@
 #include "Property.hpp"
 
 #include "Types/HomogMatrix.hpp"
+#include "Types/MatrixTranslator.hpp"
+#include "Types/HandlerStats.hpp"
 
 #include <opencv2/core/core.hpp>
 
@@ -23,6 +25,20 @@
 namespace Processors {
 namespace HomogenousMatrixProvider {
 
+/*!
+ * \class HomogenousMatrixProvider
+ * \brief Publishes poses given by the offset properties (XYZ and RPY).
+ *
+ * In the static mode the matrix is computed and published only when the offset changes.
+ * Motion modes publish a pose in every step - the offset plus the value of the motion profile
+ * at the simulated time (step number times motion.time_step), so the sequence is deterministic:
+ * - linear - motion.velocity (six values per second),
+ * - sinusoidal - motion.amplitude (six values) times sin(2 pi motion.frequency t),
+ * - table - consecutive rows of motion.table (six values each), repeated cyclically.
+ *
+ * Durations of generateHomogenousMatrix (with the numbers of published and skipped poses) are always measured;
+ * they are logged and written to out_stats every stats.interval seconds (0 - default - no reports).
+ */
 class HomogenousMatrixProvider: public Base::Component
 {
 public:
@@ -63,8 +79,26 @@ protected:
 
 private:
 
+	/// Motion profiles.
+	enum Mode { STATIC, LINEAR, SINUSOIDAL, TABLE };
+
 	void generateHomogenousMatrix();
 
+	/// Logs and publishes statistics of the handlers.
+	void publishStats();
+
+	/// Restarts the motion from the offset (time 0), triggered manually.
+	void onReset();
+
+	/// Returns the offset properties as a single vector.
+	cv::Vec6d offset() const;
+
+	/// Returns XYZRPY of the motion profile at the given step.
+	cv::Vec6d motion(unsigned long step_) const;
+
+	/// Reads six values of the matrix property (missing values are zeros).
+	static cv::Vec6d readVector(const cv::Mat & mat_, int row_ = 0);
+
 	Base::Property<double> prop_x;
 	Base::Property<double> prop_y;
 	Base::Property<double> prop_z;
@@ -72,9 +106,31 @@ private:
 	Base::Property<double> prop_pitch;
 	Base::Property<double> prop_yaw;
 
+	Base::Property<std::string> prop_mode;
+	Base::Property<double> prop_time_step;
+	Base::Property<cv::Mat, Types::MatrixTranslator> prop_velocity;
+	Base::Property<cv::Mat, Types::MatrixTranslator> prop_amplitude;
+	Base::Property<double> prop_frequency;
+	Base::Property<cv::Mat, Types::MatrixTranslator> prop_table;
+	Base::Property<double> prop_stats_interval;
+
+	Mode mode;
+
+	/// Number of the current step of the motion.
+	unsigned long step;
+
+	/// Offset of the last published pose of the static mode (and whether anything was published).
+	cv::Vec6d published_offset;
+	bool published;
+
+	/// Statistics of the handlers.
+	Types::HandlerStatsGroup stats;
+	Types::HandlerStats * stats_generate;
 
 	Base::DataStreamOut <Types::HomogMatrix> out_homogMatrix;
 
+	Base::DataStreamOut <Types::HandlerStatsReport> out_stats;
+
 	Base::EventHandler <HomogenousMatrixProvider> h_generateHomogenousMatrix;
 };
 
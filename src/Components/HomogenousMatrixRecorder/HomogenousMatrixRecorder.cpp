@@ -0,0 +1,129 @@
+/*!
+ * \file HomogenousMatrixRecorder.cpp
+ * \brief Class responsible for recording streams of homogenous matrices into binary trajectory files - methods definition.
+ */
+
+#include "HomogenousMatrixRecorder.hpp"
+
+#include <algorithm>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace Sinks {
+namespace HomogenousMatrixRecorder {
+
+HomogenousMatrixRecorder::HomogenousMatrixRecorder(const std::string & n) :
+	Base::Component(n),
+	prop_filename("filename", std::string("")),
+	prop_timestamps("timestamps", true),
+	prop_buffer_size("buffer_size", 1024)
+{
+	registerProperty(prop_filename);
+	registerProperty(prop_timestamps);
+	registerProperty(prop_buffer_size);
+
+	CLOG(LTRACE) << "Constructed";
+}
+
+HomogenousMatrixRecorder::~HomogenousMatrixRecorder() {
+	CLOG(LTRACE) << "Destroyed";
+}
+
+
+void HomogenousMatrixRecorder::prepareInterface() {
+	// Register streams.
+	registerStream("in_homogMatrix", &in_homogMatrix);
+
+	// Register handlers - records matrix, activated when new matrix arrives.
+	registerHandler("onNewHomogMatrix", boost::bind(&HomogenousMatrixRecorder::onNewHomogMatrix, this));
+	addDependency("onNewHomogMatrix", &in_homogMatrix);
+
+	// Register handlers - hands collected matrices over to the writer, triggered manually.
+	registerHandler("Flush", boost::bind(&HomogenousMatrixRecorder::onFlush, this));
+}
+
+bool HomogenousMatrixRecorder::onInit() {
+	CLOG(LTRACE) << "initialize\n";
+
+	recorded = 0;
+	record_doubles = prop_timestamps ? 7 : 6;
+	buffer_doubles = record_doubles * std::max(1, (int)prop_buffer_size);
+
+	try {
+		writer.open(prop_filename, prop_timestamps);
+	} catch (std::exception & ex) {
+		// Component stays inactive - received matrices are dropped.
+		CLOG(LERROR) << ex.what();
+		return true;
+	}//: catch
+
+	buffers.reserve(buffer_doubles);
+	buffers.start(boost::bind(&HomogenousMatrixRecorder::writeRecords, this, _1));
+
+	return true;
+}
+
+bool HomogenousMatrixRecorder::onFinish() {
+	CLOG(LTRACE) << "onFinish";
+
+	// Stops the writer thread and writes the rest directly.
+	buffers.stop();
+	writer.close();
+
+	CLOG(LINFO) << "Recorded " << recorded << " matrices to " << prop_filename;
+	return true;
+}
+
+void HomogenousMatrixRecorder::onNewHomogMatrix() {
+	CLOG(LTRACE) << "onNewHomogMatrix";
+
+	Types::HomogMatrix hm = in_homogMatrix.read();
+
+	if (!writer.isOpen())
+		return;
+
+	std::vector<double> & front_buffer = buffers.front();
+	if (prop_timestamps) {
+		boost::posix_time::time_duration t = boost::posix_time::microsec_clock::universal_time() - boost::posix_time::from_time_t(0);
+		front_buffer.push_back(t.total_microseconds() * 1e-6);
+	}//: if
+
+	cv::Vec6d xyzrpy = hm.getXYZRPY();
+	for (int i = 0; i < 6; ++i)
+		front_buffer.push_back(xyzrpy[i]);
+	++recorded;
+
+	// Hand the buffer over when full. If the writer is still busy, the front buffer simply grows.
+	if (front_buffer.size() >= buffer_doubles) {
+		if (!buffers.swap())
+			CLOG(LDEBUG) << "Writer busy - buffering " << front_buffer.size() / record_doubles << " matrices";
+	}//: if
+}
+
+void HomogenousMatrixRecorder::onFlush() {
+	CLOG(LDEBUG) << "onFlush";
+	buffers.swap();
+}
+
+void HomogenousMatrixRecorder::writeRecords(const std::vector<double> & buffer_) {
+	try {
+		writer.appendRecords(&buffer_[0], buffer_.size() / record_doubles);
+		writer.flush();
+	} catch (std::exception & ex) {
+		CLOG(LERROR) << ex.what();
+	}//: catch
+}
+
+bool HomogenousMatrixRecorder::onStart() {
+	return true;
+}
+
+bool HomogenousMatrixRecorder::onStop() {
+	// Do not keep the collected matrices in memory while stopped.
+	buffers.swap();
+	return true;
+}
+
+
+}//: namespace HomogenousMatrixRecorder
+}//: namespace Sinks
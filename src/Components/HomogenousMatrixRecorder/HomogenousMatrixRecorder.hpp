@@ -0,0 +1,130 @@
+/*!
+ * \file HomogenousMatrixRecorder.hpp
+ * \brief Class responsible for recording streams of homogenous matrices into binary trajectory files - class declaration.
+ */
+
+
+#ifndef HomogenousMatrixRecorder_HPP_
+#define HomogenousMatrixRecorder_HPP_
+
+#include "Component_Aux.hpp"
+#include "Component.hpp"
+#include "DataStream.hpp"
+#include "Property.hpp"
+
+#include "Types/DoubleBufferedWriter.hpp"
+#include "Types/HomogMatrix.hpp"
+#include "Types/TrajectoryFile.hpp"
+
+#include <vector>
+
+/**
+ * \defgroup HomogenousMatrixRecorder HomogenousMatrixRecorder
+ *
+ * \brief Records homogenous matrices into binary trajectory files, which can be replayed by HomogenousMatrixSequence.
+ */
+
+namespace Sinks {
+namespace HomogenousMatrixRecorder {
+
+/*!
+ * \class HomogenousMatrixRecorder
+ * \brief Class responsible for recording streams of homogenous matrices.
+ *
+ * Every received matrix is appended (with a timestamp) to the front buffer. Full buffers are handed over
+ * to the writer thread (see Types::DoubleBufferedWriter), so the executor never waits for the disk.
+ */
+class HomogenousMatrixRecorder : public Base::Component {
+
+public:
+	/// Input buffers hold HomogMatrix instances, so the component must be allocated aligned.
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+	/*!
+	 * Constructor. Sets ID and startup variables.
+	 */
+	HomogenousMatrixRecorder(const std::string & name = "HomogenousMatrixRecorder");
+
+	/*!
+	 * Destructor.
+	 */
+	virtual ~HomogenousMatrixRecorder();
+
+	virtual void prepareInterface();
+
+protected:
+
+	/*!
+	 * Opens the file and starts the writer thread.
+	 */
+	bool onInit();
+
+	/*!
+	 * Writes the remaining records, stops the writer thread and closes the file.
+	 */
+	bool onFinish();
+
+	/*!
+	 * Start component
+	 */
+	bool onStart();
+
+	/*!
+	 * Stop component
+	 */
+	bool onStop();
+
+	/// Input data stream - recorded matrices.
+	Base::DataStreamIn <Types::HomogMatrix, Base::DataStreamBuffer::Queue> in_homogMatrix;
+
+	/*!
+	 * Event handler function - appends received matrix to the front buffer.
+	 */
+	void onNewHomogMatrix();
+
+	/*!
+	 * Event handler function - hands the front buffer over to the writer thread.
+	 */
+	void onFlush();
+
+private:
+	/*!
+	 * Writes records of a buffer to the file - called by the writer thread.
+	 */
+	void writeRecords(const std::vector<double> & buffer_);
+
+	/// Writer of the trajectory file.
+	Types::TrajectoryWriter writer;
+
+	/// Records laid out as in the file - filled by the handler, written by the writer thread.
+	Types::DoubleBufferedWriter<std::vector<double> > buffers;
+
+	/// Number of doubles in a single record.
+	size_t record_doubles;
+
+	/// Number of doubles collected before the front buffer is handed over (buffer_size records, at least one).
+	size_t buffer_doubles;
+
+	/// Number of recorded matrices.
+	size_t recorded;
+
+
+	/// Output file (binary trajectory).
+	Base::Property<std::string> prop_filename;
+
+	/// Record timestamps (seconds since the epoch) along with the matrices.
+	Base::Property<bool> prop_timestamps;
+
+	/// Number of records collected in the front buffer before it is handed over to the writer.
+	Base::Property<int> prop_buffer_size;
+};
+
+}//: namespace HomogenousMatrixRecorder
+}//: namespace Sinks
+
+/*
+ * Register sink component.
+ */
+REGISTER_COMPONENT("HomogenousMatrixRecorder", Sinks::HomogenousMatrixRecorder::HomogenousMatrixRecorder)
+
+#endif /* HomogenousMatrixRecorder_HPP_ */
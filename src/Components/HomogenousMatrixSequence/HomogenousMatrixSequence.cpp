@@ -18,7 +18,11 @@ HomogenousMatrixSequence::HomogenousMatrixSequence(const std::string & n) :
 	prop_read_on_init("mode.read_on_init", true),
 	prop_auto_publish("mode.auto_publish", true),
 	prop_auto_next("mode.auto_next", true),
-	prop_auto_prev("mode.auto_prev", false)
+	prop_auto_prev("mode.auto_prev", false),
+	prop_prefetch_window("prefetch_window", 4096),
+	prop_precompute("mode.precompute", false),
+	prop_batch_size("batch.size", 0),
+	prop_stats_interval("stats.interval", 0.0)
 {
 	registerProperty(prop_filename);
 	registerProperty(prop_read_on_init);
@@ -26,11 +30,18 @@ HomogenousMatrixSequence::HomogenousMatrixSequence(const std::string & n) :
 	registerProperty(prop_auto_publish);
 	registerProperty(prop_auto_next);
 	registerProperty(prop_auto_prev);
+	registerProperty(prop_prefetch_window);
+	registerProperty(prop_precompute);
+	registerProperty(prop_batch_size);
+	registerProperty(prop_stats_interval);
+
+	stats_load = &stats.add("onLoad");
 
 	CLOG(LTRACE) << "Constructed";
 }
 
 HomogenousMatrixSequence::~HomogenousMatrixSequence() {
+	waitForLoader();
 	CLOG(LTRACE) << "Destroyed";
 }
 
@@ -38,7 +49,9 @@ HomogenousMatrixSequence::~HomogenousMatrixSequence() {
 void HomogenousMatrixSequence::prepareInterface() {
 	// Register streams.
 	registerStream("out_homogMatrix", &out_homogMatrix);
+	registerStream("out_poses", &out_poses);
 	registerStream("out_end_of_sequence_trigger", &out_end_of_sequence_trigger);
+	registerStream("out_stats", &out_stats);
 	registerStream("in_publish_trigger", &in_publish_trigger);
 	registerStream("in_next_trigger", &in_next_trigger);
 	registerStream("in_prev_trigger", &in_prev_trigger);
@@ -69,20 +82,121 @@ bool HomogenousMatrixSequence::onInit() {
 	// Set indices.
 	index = 0;
 	previous_index = -1;
+	prefetch_begin = prefetch_end = 0;
 
 	// Initialize flags.
 	next_flag = false;
 	prev_flag = false;
-	reload_flag = true;
+	loader_busy = false;
+
+	stats.setInterval(prop_stats_interval);
+
+	// Start with an empty sequence.
+	sequence.reset(new PoseSequence);
+
+	if (prop_read_on_init) {
+		// Load the sequence before the executor starts - nothing to stall yet.
+		loadSequence(prop_filename);
+		reload_flag = false;
+	} else {
+		// Load the sequence in the background.
+		reload_flag = true;
+	}
 
 	return true;
 }
 
 bool HomogenousMatrixSequence::onFinish() {
 	CLOG(LTRACE) << "onFinish";
+	waitForLoader();
+	return true;
+}
+
+void HomogenousMatrixSequence::loadSequence(const std::string & filename_) {
+	boost::shared_ptr<PoseSequence> seq(new PoseSequence);
+
+	try {
+		seq->load(filename_);
+		CLOG(LDEBUG) << "Loaded " << seq->size() << " XYZRPY Hm's from " << filename_;
+		CLOG(LTRACE) << "Loaded matrix of XYZRPY Hm's:\n" << *seq;
+
+		if (prop_precompute) {
+			seq->precompute();
+			CLOG(LDEBUG) << "Precomputed " << seq->size() << " Hm's";
+		}
+
+	} catch(std::exception & ex) {
+		CLOG(LERROR) << "Could not load matrix of XYZRPY  from file: " << filename_ << " (" << ex.what() << ")";
+		seq->clear();
+	} catch(...) {
+		CLOG(LERROR) << "Could not load matrix of XYZRPY  from file: " << filename_;
+		seq->clear();
+	}//: catch
+
+	// Hand the sequence over - it will be swapped in by the next onLoad.
+	boost::mutex::scoped_lock lock(loader_mutex);
+	loaded_sequence = seq;
+	loader_busy = false;
+}
+
+bool HomogenousMatrixSequence::startLoader() {
+	boost::mutex::scoped_lock lock(loader_mutex);
+	if (loader_busy)
+		return false;
+	loader_busy = true;
+	lock.unlock();
+
+	// Previous loader (if any) has already finished its work.
+	if (loader)
+		loader->join();
+	loader.reset(new boost::thread(boost::bind(&HomogenousMatrixSequence::loadSequence, this, std::string(prop_filename))));
+	return true;
+}
+
+void HomogenousMatrixSequence::waitForLoader() {
+	if (loader) {
+		loader->join();
+		loader.reset();
+	}
+}
+
+bool HomogenousMatrixSequence::swapLoadedSequence() {
+	boost::shared_ptr<PoseSequence> seq;
+	{
+		boost::mutex::scoped_lock lock(loader_mutex);
+		seq.swap(loaded_sequence);
+	}
+	if (!seq)
+		return false;
+
+	// Old sequence is released here (or by the last reader still holding it).
+	sequence = seq;
+	prefetch_begin = prefetch_end = 0;
 	return true;
 }
 
+void HomogenousMatrixSequence::prefetch() {
+	int window = prop_prefetch_window;
+	if (window <= 0)
+		return;
+
+	// Issue the read-ahead only when the index leaves the first half of the current window.
+	if ((index >= prefetch_begin) && (index + window / 2 < prefetch_end))
+		return;
+
+	prefetch_begin = index;
+	prefetch_end = index + window;
+	sequence->prefetch(prefetch_begin, window);
+}
+
+int HomogenousMatrixSequence::step() const {
+	if (prop_batch_size == 0)
+		return 1;
+	if (prop_batch_size < 0)
+		return std::max<int>(sequence->size(), 1);
+	return prop_batch_size;
+}
+
 void HomogenousMatrixSequence::onPublish() {
 	CLOG(LTRACE) << "onPublish";
 
@@ -95,35 +209,36 @@ void HomogenousMatrixSequence::onPublish() {
 void HomogenousMatrixSequence::onLoad() {
 	CLOG(LTRACE) << "onLoad";
 
+	if (stats.reportDue())
+		publishStats();
+	// Calls which end without publishing a matrix are counted as skipped.
+	Types::HandlerStats::Scope timer(*stats_load);
+
 	CLOG(LDEBUG) << "Before index=" << index << " previous_index=" << previous_index;
 
 	
 	if(reload_flag) {
-		// Reload the sequence.
+		// Reload the sequence in the background - the current one is used until the new one is ready.
+		if (startLoader())
+			reload_flag = false;
+	}//: if
 
-		try {
-			cv::FileStorage fs(prop_filename, cv::FileStorage::READ);
-			fs["XYZRPY"] >> matrices;
-			CLOG(LDEBUG) << "Loaded matrix of XYZRPY Hm's:\n" << matrices;
-
-		} catch(...) {
-			CLOG(LERROR) << "Could not load matrix of XYZRPY  from file: " << prop_filename;
-		}//: catch
-
-		// Reset index and flag.
+	if(swapLoadedSequence()) {
+		// New sequence - reset index.
 		index = 0;
-		reload_flag = false;
 	} else if (previous_index == -1) {
 		// Special case - start!
 			index = 0;
 	} else {
+		const int n = step();
+
 		// Check triggering mode.
 		if ((prop_auto_next) || (next_flag)) {
-			index++;
+			index += n;
 		}//: if
 
 		if ((prop_auto_prev) || (prev_flag)) {
-			index--;
+			index -= n;
 		}//: if
 
 		// Anyway, reset flags.
@@ -134,7 +249,8 @@ void HomogenousMatrixSequence::onLoad() {
 		if (index <0){
 			out_end_of_sequence_trigger.write(Base::UnitType());
 			if (prop_loop) {
-				index = matrices.rows -1;
+				// Start of the last window (the last matrix if not in the batch mode).
+				index = std::max<int>(sequence->size() - 1, 0) / n * n;
 				CLOG(LDEBUG) << "Loop";
 			} else {
 				// Sequence ended - truncate index, but do not return matrix.
@@ -145,7 +261,7 @@ void HomogenousMatrixSequence::onLoad() {
 		}//: if
 
 		// Check index range - last image.
-		if (index >= matrices.rows) {
+		if (index >= (int)sequence->size()) {
 			out_end_of_sequence_trigger.write(Base::UnitType());
 			CLOG(LINFO) << "End of HomogenousMatrixSequence";
 			if (prop_loop) {
@@ -153,18 +269,25 @@ void HomogenousMatrixSequence::onLoad() {
 				CLOG(LINFO) << "loop";
 			} else {
 				// Sequence ended - truncate index, but do not return matrix.
-				index = matrices.rows -1;
+				index = std::max<int>(sequence->size() - 1, 0) / n * n;
 				return;
 			}//: else
 		}//: if
 	}//: else
 
 	// Check whether there are any matrices loaded.
-	if(matrices.rows == 0){
-		CLOG(LNOTICE) << "Empty sequence!";
+	if(sequence->size() == 0){
+		boost::mutex::scoped_lock lock(loader_mutex);
+		if (loader_busy)
+			CLOG(LDEBUG) << "Sequence is being loaded";
+		else
+			CLOG(LNOTICE) << "Empty sequence!";
 		return;
 	}//: else
 
+	// Keep the upcoming poses paged in.
+	prefetch();
+
 	// Check publishing flags.
 	if(!prop_auto_publish && !publish_flag)
 		return;
@@ -173,18 +296,31 @@ void HomogenousMatrixSequence::onLoad() {
 	CLOG(LDEBUG) << "After: index=" << index << " previous_index=" << previous_index ;
 
 	try {
-		cv::Vec6d* hm_vector = matrices.ptr<cv::Vec6d>(index);
-		//cv::Mat hm_vector = matrices.row(index);
-		CLOG(LDEBUG) << "Returning matrix (" << index << "): " <<  (*hm_vector);
-
-		// Create matrix from XYZ and RPY angles.
-		Types::HomogMatrix hm;
-		hm.setFromXYZRPY(*hm_vector);
-
-		CLOG(LDEBUG) <<"Returned matrix:\n"<<hm;
 		previous_index = index;
-		// Write to the output port.
-		out_homogMatrix.write(hm);
+
+		if (prop_batch_size != 0) {
+			// The whole window in a single message - precomputed poses are not even copied.
+			const Types::PoseArray poses = sequence->window(index, step());
+			CLOG(LDEBUG) << "Returning " << poses.size() << " matrices from " << index;
+			out_poses.write(poses);
+			timer.published();
+		} else if (sequence->isPrecomputed()) {
+			// Write the precomputed matrix to the output port.
+			out_homogMatrix.write(sequence->pose(index));
+			timer.published();
+		} else {
+			cv::Vec6d hm_vector = sequence->xyzrpy(index);
+			CLOG(LDEBUG) << "Returning matrix (" << index << "): " <<  hm_vector;
+
+			// Create matrix from XYZ and RPY angles.
+			Types::HomogMatrix hm;
+			hm.setFromXYZRPY(hm_vector);
+
+			CLOG(LDEBUG) <<"Returned matrix:\n"<<hm;
+			// Write to the output port.
+			out_homogMatrix.write(hm);
+			timer.published();
+		}//: else
 
 	} catch (...) {
 		CLOG(LWARNING) << "Publish failed on index " << index;
@@ -194,6 +330,13 @@ void HomogenousMatrixSequence::onLoad() {
 
 
 
+void HomogenousMatrixSequence::publishStats() {
+	const Types::HandlerStatsReport report = stats.snapshot();
+	for (size_t i = 0; i < report.size(); ++i)
+		CLOG(LINFO) << report[i];
+	out_stats.write(report);
+}
+
 void HomogenousMatrixSequence::onLoadNext(){
 	CLOG(LDEBUG) << "onLoadNext - next matrix will be loaded";
 	if(!in_next_trigger.empty())
@@ -13,6 +13,14 @@
 #include "Property.hpp"
 
 #include "Types/HomogMatrix.hpp"
+#include "Types/HandlerStats.hpp"
+#include "Types/PoseArray.hpp"
+
+#include "PoseSequence.hpp"
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
 
 //#include <vector>
 //#include <string>
@@ -31,6 +39,10 @@ namespace HomogenousMatrixSequence {
 /*!
  * \class HomogenousMatrixSequence
  * \brief Class responsible for retrieving vector of homogenous matrices.
+ *
+ * In the batch mode (batch.size other than 0) windows of batch.size poses (or the whole sequence,
+ * if batch.size is negative) are published as single Types::PoseArray messages on out_poses,
+ * and next/previous move by a whole window.
  */
 class HomogenousMatrixSequence : public Base::Component {
 
@@ -81,9 +93,15 @@ protected:
 	/// Output data stream
 	Base::DataStreamOut <Types::HomogMatrix> out_homogMatrix;
 
+	/// Output data stream - windows of poses (batch mode).
+	Base::DataStreamOut <Types::PoseArray> out_poses;
+
 	/// Output event - sequence ended.
 	Base::DataStreamOut<Base::UnitType> out_end_of_sequence_trigger;
 
+	/// Output data stream - statistics of the handlers.
+	Base::DataStreamOut<Types::HandlerStatsReport> out_stats;
+
 	/*!
 	* Event handler function - moves index to next matrix from sequence.
 	*/
@@ -111,8 +129,56 @@ protected:
 	void onPublish();
 
 private:
-	/// Matrix containing list of homogenous matrices - each vector represents a single HM in the form of XYZRPY.
-	cv::Mat matrices;
+	/*!
+	 * Loads the sequence and hands it over to onLoad - called in the loader thread (or in onInit).
+	 */
+	void loadSequence(const std::string & filename_);
+
+	/*!
+	 * Starts loading of the sequence in the loader thread.
+	 * \return false if the loader is still busy with the previous request.
+	 */
+	bool startLoader();
+
+	/*!
+	 * Waits until the loader thread finishes.
+	 */
+	void waitForLoader();
+
+	/*!
+	 * Replaces the current sequence with the one prepared by the loader.
+	 * \return true if the sequence was replaced.
+	 */
+	bool swapLoadedSequence();
+
+	/*!
+	 * Starts read-ahead of the poses following the current index.
+	 */
+	void prefetch();
+
+	/*!
+	 * Number of poses published at once - 1 unless in the batch mode.
+	 */
+	int step() const;
+
+	/// Sequence of homogenous matrices - each pose represents a single HM in the form of XYZRPY.
+	boost::shared_ptr<PoseSequence> sequence;
+
+	/// Sequence prepared by the loader thread, waiting to be swapped in.
+	boost::shared_ptr<PoseSequence> loaded_sequence;
+
+	/// Thread loading the sequence in the background.
+	boost::scoped_ptr<boost::thread> loader;
+
+	/// Mutex guarding loaded_sequence and loader_busy.
+	boost::mutex loader_mutex;
+
+	/// Flag indicating whether the loader thread is working.
+	bool loader_busy;
+
+	/// Range of poses covered by the last read-ahead.
+	int prefetch_begin;
+	int prefetch_end;
 
 
 	/// Index of current matrix.
@@ -135,7 +201,7 @@ private:
 	bool reload_flag;
 
 
-	/// File containing the vector of matrices (in the form of matrix, each row containing one HM in the form of XYZRPY).
+	/// File containing the vector of matrices (in the form of matrix, each row containing one HM in the form of XYZRPY) or binary trajectory file.
 	Base::Property<std::string> prop_filename;
 
 	/// Publish mode: auto vs triggered.
@@ -150,9 +216,30 @@ private:
 	/// Loading mode: images loaded in the loop.
 	Base::Property<bool> prop_loop;
 
-	/// Loads whole sequence at start.
+	/// Loads whole sequence at start (in onInit), otherwise the sequence is loaded in the background.
 	Base::Property<bool> prop_read_on_init;
 
+	/// Number of poses read ahead of the current one (memory-mapped trajectories only, 0 disables read-ahead).
+	Base::Property<int> prop_prefetch_window;
+
+	/// Converts the whole sequence to homogenous matrices at load, so publishing is just a copy.
+	Base::Property<bool> prop_precompute;
+
+	/// Number of poses published in a single PoseArray message, 0 - single matrices, negative - whole sequence.
+	Base::Property<int> prop_batch_size;
+
+	/// Time between reports of the handler statistics [s], 0 - no reports.
+	Base::Property<double> prop_stats_interval;
+
+	/// Statistics of the handlers.
+	Types::HandlerStatsGroup stats;
+	Types::HandlerStats * stats_load;
+
+	/*!
+	 * Logs and publishes statistics of the handlers.
+	 */
+	void publishStats();
+
 };
 
 }//: namespace HomogenousMatrixSequence
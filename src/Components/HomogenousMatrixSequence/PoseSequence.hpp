@@ -0,0 +1,173 @@
+/*!
+ * \file PoseSequence.hpp
+ * \brief Sequence of poses (XYZRPY) loaded from a YAML/XML file or memory-mapped from a binary trajectory file.
+ */
+
+#ifndef POSESEQUENCE_HPP_
+#define POSESEQUENCE_HPP_
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <opencv2/core/core.hpp>
+
+#include "Types/HomogMatrix.hpp"
+#include "Types/PoseArray.hpp"
+#include "Types/TrajectoryFile.hpp"
+
+namespace Sources {
+namespace HomogenousMatrixSequence {
+
+/*!
+ * \class PoseSequence
+ * \brief Random access to poses in the form of XYZRPY, independent of the file format.
+ */
+class PoseSequence : private boost::noncopyable {
+public:
+	/*!
+	 * Loads the sequence. Binary trajectory files (see Types/TrajectoryFile.hpp) are memory-mapped,
+	 * other files are parsed with cv::FileStorage (XYZRPY node). Throws std::exception on failure.
+	 */
+	void load(const std::string & filename_) {
+		clear();
+		if (Types::TrajectoryReader::isTrajectoryFile(filename_)) {
+			trajectory.open(filename_);
+		} else {
+			cv::FileStorage fs(filename_, cv::FileStorage::READ);
+			fs["XYZRPY"] >> matrices;
+		}
+	}
+
+	/// Releases the sequence.
+	void clear() {
+		trajectory.close();
+		matrices.release();
+		poses.reset();
+		timestamps.reset();
+	}
+
+	/*!
+	 * Converts all poses to homogenous matrices, so they do not have to be computed on every publish.
+	 * Conversion is split between the given number of threads (0 - one per hardware thread).
+	 */
+	void precompute(unsigned threads_ = 0) {
+		const size_t n = size();
+		poses.reset(new Types::PoseArray::Poses(n));
+
+		if (threads_ == 0)
+			threads_ = std::max(1u, boost::thread::hardware_concurrency());
+		// Do not bother spawning threads for short sequences.
+		const size_t min_chunk = 4096;
+		threads_ = std::max<size_t>(1, std::min<size_t>(threads_, n / min_chunk));
+
+		const size_t chunk = (n + threads_ - 1) / threads_;
+		boost::thread_group workers;
+		for (size_t begin = chunk; begin < n; begin += chunk)
+			workers.create_thread(boost::bind(&PoseSequence::convert, this, begin, std::min(n, begin + chunk)));
+		// The calling thread converts the first chunk itself.
+		convert(0, std::min(n, chunk));
+		workers.join_all();
+
+		if (hasTimestamps()) {
+			boost::shared_ptr<std::vector<double> > ts(new std::vector<double>(n));
+			for (size_t i = 0; i < n; ++i)
+				(*ts)[i] = timestamp(i);
+			timestamps = ts;
+		}
+	}
+
+	/// Returns true if homogenous matrices were precomputed.
+	bool isPrecomputed() const {
+		return poses && poses->size() == size();
+	}
+
+	/// Returns precomputed homogenous matrix with given index.
+	const Types::HomogMatrix & pose(size_t index_) const {
+		return (*poses)[index_];
+	}
+
+	/*!
+	 * Returns poses [first, first + n) (truncated to the end of the sequence) as a single array.
+	 * Precomputed poses are shared, others are converted into a new block.
+	 */
+	Types::PoseArray window(size_t first_, size_t n_) const {
+		first_ = std::min(first_, size());
+		n_ = std::min(n_, size() - first_);
+		if (isPrecomputed())
+			return Types::PoseArray(poses, first_, n_, timestamps, first_);
+
+		boost::shared_ptr<Types::PoseArray::Poses> block(new Types::PoseArray::Poses(n_));
+		boost::shared_ptr<std::vector<double> > ts;
+		if (hasTimestamps())
+			ts.reset(new std::vector<double>(n_));
+		for (size_t i = 0; i < n_; ++i) {
+			(*block)[i].setFromXYZRPY(xyzrpy(first_ + i));
+			if (ts)
+				(*ts)[i] = timestamp(first_ + i);
+		}
+		return Types::PoseArray(block, 0, n_, ts, first_);
+	}
+
+	/// Number of poses.
+	size_t size() const {
+		return trajectory.isOpen() ? trajectory.size() : matrices.rows;
+	}
+
+	/// Returns pose with given index in the form of XYZRPY.
+	cv::Vec6d xyzrpy(size_t index_) const {
+		return trajectory.isOpen() ? trajectory.xyzrpy(index_) : *matrices.ptr<cv::Vec6d>(index_);
+	}
+
+	/// Returns true if poses are timestamped (only binary trajectories can contain timestamps).
+	bool hasTimestamps() const {
+		return trajectory.hasTimestamps();
+	}
+
+	/// Returns timestamp of the pose with given index (0 if poses are not timestamped).
+	double timestamp(size_t index_) const {
+		return trajectory.timestamp(index_);
+	}
+
+	/// Starts background read-ahead of poses [begin, begin + n) - only memory-mapped trajectories need it.
+	void prefetch(size_t begin_, size_t n_) const {
+		trajectory.prefetch(begin_, n_);
+	}
+
+	/// Displays all poses, one per line.
+	friend std::ostream & operator<< (std::ostream & out_, const PoseSequence & seq_) {
+		for (size_t i = 0; i < seq_.size(); ++i)
+			out_ << seq_.xyzrpy(i) << "\n";
+		return out_;
+	}
+
+private:
+	/// Converts poses [begin, end) to homogenous matrices.
+	void convert(size_t begin_, size_t end_) {
+		for (size_t i = begin_; i < end_; ++i)
+			(*poses)[i].setFromXYZRPY(xyzrpy(i));
+	}
+
+	/// Memory-mapped binary trajectory.
+	Types::TrajectoryReader trajectory;
+
+	/// Matrix containing poses read from YAML/XML file - each row represents a single HM in the form of XYZRPY.
+	cv::Mat matrices;
+
+	/// Precomputed homogenous matrices (contiguous, aligned for Eigen) - shared with the published arrays.
+	boost::shared_ptr<Types::PoseArray::Poses> poses;
+
+	/// Timestamps of the precomputed poses (if the sequence is timestamped).
+	boost::shared_ptr<const std::vector<double> > timestamps;
+};
+
+}//: namespace HomogenousMatrixSequence
+}//: namespace Sources
+
+#endif /* POSESEQUENCE_HPP_ */
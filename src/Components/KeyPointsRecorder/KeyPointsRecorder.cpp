@@ -0,0 +1,145 @@
+/*!
+ * \file KeyPointsRecorder.cpp
+ * \brief Class responsible for recording streams of keypoints into binary keypoints files - methods definition.
+ */
+
+#include "KeyPointsRecorder.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace Sinks {
+namespace KeyPointsRecorder {
+
+KeyPointsRecorder::KeyPointsRecorder(const std::string & n) :
+	Base::Component(n),
+	prop_filename("filename", std::string("")),
+	prop_buffer_size("buffer_size", 16)
+{
+	registerProperty(prop_filename);
+	registerProperty(prop_buffer_size);
+
+	CLOG(LTRACE) << "Constructed";
+}
+
+KeyPointsRecorder::~KeyPointsRecorder() {
+	CLOG(LTRACE) << "Destroyed";
+}
+
+
+void KeyPointsRecorder::prepareInterface() {
+	// Register streams.
+	registerStream("in_keypoints", &in_keypoints);
+	registerStream("in_features", &in_features);
+
+	// Register handlers - records keypoints, activated when new keypoints arrive.
+	registerHandler("onNewKeyPoints", boost::bind(&KeyPointsRecorder::onNewKeyPoints, this));
+	addDependency("onNewKeyPoints", &in_keypoints);
+
+	// Register handlers - records keypoints with descriptors, activated when new features arrive.
+	registerHandler("onNewFeatures", boost::bind(&KeyPointsRecorder::onNewFeatures, this));
+	addDependency("onNewFeatures", &in_features);
+
+	// Register handlers - hands collected frames over to the writer, triggered manually.
+	registerHandler("Flush", boost::bind(&KeyPointsRecorder::onFlush, this));
+}
+
+bool KeyPointsRecorder::onInit() {
+	CLOG(LTRACE) << "initialize\n";
+
+	recorded = 0;
+	buffered_frames = 0;
+
+	try {
+		writer.open(prop_filename);
+	} catch (std::exception & ex) {
+		// Component stays inactive - received keypoints are dropped.
+		CLOG(LERROR) << ex.what();
+		return true;
+	}//: catch
+
+	buffers.start(boost::bind(&KeyPointsRecorder::writeFrames, this, _1));
+
+	return true;
+}
+
+bool KeyPointsRecorder::onFinish() {
+	CLOG(LTRACE) << "onFinish";
+
+	// Stops the writer thread and writes the rest directly.
+	buffers.stop();
+	buffered_frames = 0;
+	writer.close();
+
+	CLOG(LINFO) << "Recorded " << recorded << " frames of keypoints to " << prop_filename;
+	return true;
+}
+
+void KeyPointsRecorder::onNewKeyPoints() {
+	CLOG(LTRACE) << "onNewKeyPoints";
+
+	Types::KeyPoints kps = in_keypoints.read();
+	record(kps.keypoints, cv::Mat());
+}
+
+void KeyPointsRecorder::onNewFeatures() {
+	CLOG(LTRACE) << "onNewFeatures";
+
+	Types::KeyPointsDescriptors features = in_features.read();
+	record(features.keypoints, features.descriptorsMat());
+}
+
+void KeyPointsRecorder::record(const std::vector<cv::KeyPoint> & keypoints_, const cv::Mat & descriptors_) {
+	if (!writer.isOpen())
+		return;
+
+	boost::posix_time::time_duration t = boost::posix_time::microsec_clock::universal_time() - boost::posix_time::from_time_t(0);
+	try {
+		Types::KeyPointsFrame::serialize(keypoints_, descriptors_, t.total_microseconds() * 1e-6, buffers.front());
+	} catch (std::exception & ex) {
+		CLOG(LERROR) << "Could not record keypoints: " << ex.what();
+		return;
+	}//: catch
+	++buffered_frames;
+	++recorded;
+
+	// Hand the buffer over when full. If the writer is still busy, the front buffer simply grows.
+	if (buffered_frames >= prop_buffer_size) {
+		if (!swapBuffers())
+			CLOG(LDEBUG) << "Writer busy - buffering " << buffered_frames << " frames";
+	}//: if
+}
+
+void KeyPointsRecorder::onFlush() {
+	CLOG(LDEBUG) << "onFlush";
+	swapBuffers();
+}
+
+bool KeyPointsRecorder::swapBuffers() {
+	if (!buffers.swap())
+		return false;
+	buffered_frames = 0;
+	return true;
+}
+
+void KeyPointsRecorder::writeFrames(const std::vector<char> & buffer_) {
+	try {
+		writer.appendFrames(&buffer_[0], buffer_.size());
+		writer.flush();
+	} catch (std::exception & ex) {
+		CLOG(LERROR) << ex.what();
+	}//: catch
+}
+
+bool KeyPointsRecorder::onStart() {
+	return true;
+}
+
+bool KeyPointsRecorder::onStop() {
+	// Do not keep the collected frames in memory while stopped.
+	swapBuffers();
+	return true;
+}
+
+
+}//: namespace KeyPointsRecorder
+}//: namespace Sinks
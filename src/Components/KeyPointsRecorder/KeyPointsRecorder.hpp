@@ -0,0 +1,141 @@
+/*!
+ * \file KeyPointsRecorder.hpp
+ * \brief Class responsible for recording streams of keypoints into binary keypoints files - class declaration.
+ */
+
+
+#ifndef KeyPointsRecorder_HPP_
+#define KeyPointsRecorder_HPP_
+
+#include "Component_Aux.hpp"
+#include "Component.hpp"
+#include "DataStream.hpp"
+#include "Property.hpp"
+
+#include "Types/DoubleBufferedWriter.hpp"
+#include "Types/KeyPoints.hpp"
+#include "Types/KeyPointsDescriptors.hpp"
+#include "Types/KeyPointsFile.hpp"
+
+#include <vector>
+
+/**
+ * \defgroup KeyPointsRecorder KeyPointsRecorder
+ *
+ * \brief Records keypoints (with descriptors) into binary keypoints files, which can be replayed by KeyPointsSequence.
+ */
+
+namespace Sinks {
+namespace KeyPointsRecorder {
+
+/*!
+ * \class KeyPointsRecorder
+ * \brief Class responsible for recording streams of keypoints.
+ *
+ * Every received frame is serialized (with a timestamp) into the front buffer. Full buffers are handed over
+ * to the writer thread (see Types::DoubleBufferedWriter), so the executor never waits for the disk.
+ */
+class KeyPointsRecorder : public Base::Component {
+
+public:
+	/*!
+	 * Constructor. Sets ID and startup variables.
+	 */
+	KeyPointsRecorder(const std::string & name = "KeyPointsRecorder");
+
+	/*!
+	 * Destructor.
+	 */
+	virtual ~KeyPointsRecorder();
+
+	virtual void prepareInterface();
+
+protected:
+
+	/*!
+	 * Opens the file and starts the writer thread.
+	 */
+	bool onInit();
+
+	/*!
+	 * Writes the remaining frames, stops the writer thread and closes the file (writing the frame index).
+	 */
+	bool onFinish();
+
+	/*!
+	 * Start component
+	 */
+	bool onStart();
+
+	/*!
+	 * Stop component
+	 */
+	bool onStop();
+
+	/// Input data stream - recorded keypoints.
+	Base::DataStreamIn <Types::KeyPoints, Base::DataStreamBuffer::Queue> in_keypoints;
+
+	/// Input data stream - recorded keypoints with descriptors.
+	Base::DataStreamIn <Types::KeyPointsDescriptors, Base::DataStreamBuffer::Queue> in_features;
+
+	/*!
+	 * Event handler function - appends received keypoints to the front buffer.
+	 */
+	void onNewKeyPoints();
+
+	/*!
+	 * Event handler function - appends received keypoints and descriptors to the front buffer.
+	 */
+	void onNewFeatures();
+
+	/*!
+	 * Event handler function - hands the front buffer over to the writer thread.
+	 */
+	void onFlush();
+
+private:
+	/*!
+	 * Serializes frame into the front buffer.
+	 */
+	void record(const std::vector<cv::KeyPoint> & keypoints_, const cv::Mat & descriptors_);
+
+	/*!
+	 * Writes frames of a buffer to the file - called by the writer thread.
+	 */
+	void writeFrames(const std::vector<char> & buffer_);
+
+	/*!
+	 * Swaps the buffers if the writer is idle.
+	 * \return false if the writer is still busy with the previous buffer.
+	 */
+	bool swapBuffers();
+
+	/// Writer of the keypoints file.
+	Types::KeyPointsFileWriter writer;
+
+	/// Frames serialized as in the file - filled by the handlers, written by the writer thread.
+	Types::DoubleBufferedWriter<std::vector<char> > buffers;
+
+	/// Number of frames in the front buffer.
+	int buffered_frames;
+
+	/// Number of recorded frames.
+	size_t recorded;
+
+
+	/// Output file (binary keypoints file).
+	Base::Property<std::string> prop_filename;
+
+	/// Number of frames collected in the front buffer before it is handed over to the writer.
+	Base::Property<int> prop_buffer_size;
+};
+
+}//: namespace KeyPointsRecorder
+}//: namespace Sinks
+
+/*
+ * Register sink component.
+ */
+REGISTER_COMPONENT("KeyPointsRecorder", Sinks::KeyPointsRecorder::KeyPointsRecorder)
+
+#endif /* KeyPointsRecorder_HPP_ */
@@ -0,0 +1,157 @@
+/*!
+ * \file KeyPointsSequence.cpp
+ * \brief Class responsible for replaying keypoints recorded in binary keypoints files - methods definition.
+ */
+
+#include "KeyPointsSequence.hpp"
+
+namespace Sources {
+namespace KeyPointsSequence {
+
+KeyPointsSequence::KeyPointsSequence(const std::string & n) :
+	Base::Component(n),
+	prop_filename("filename", std::string("")),
+	prop_loop("mode.loop", false),
+	prop_fps("fps", 0.0),
+	prop_prefetch_window("prefetch_window", 64)
+{
+	registerProperty(prop_filename);
+	registerProperty(prop_loop);
+	registerProperty(prop_fps);
+	registerProperty(prop_prefetch_window);
+
+	CLOG(LTRACE) << "Constructed";
+}
+
+KeyPointsSequence::~KeyPointsSequence() {
+	CLOG(LTRACE) << "Destroyed";
+}
+
+
+void KeyPointsSequence::prepareInterface() {
+	// Register streams.
+	registerStream("out_keypoints", &out_keypoints);
+	registerStream("out_features", &out_features);
+	registerStream("out_end_of_sequence_trigger", &out_end_of_sequence_trigger);
+
+	// Register handlers - publishes frames, NULL dependency.
+	registerHandler("onLoad", boost::bind(&KeyPointsSequence::onLoad, this));
+	addDependency("onLoad", NULL);
+
+	// Register handlers - reloads the sequence, triggered manually.
+	registerHandler("Reload Sequence", boost::bind(&KeyPointsSequence::onSequenceReload, this));
+}
+
+bool KeyPointsSequence::onInit() {
+	CLOG(LTRACE) << "initialize\n";
+
+	reload_flag = false;
+	openSequence();
+
+	return true;
+}
+
+bool KeyPointsSequence::onFinish() {
+	CLOG(LTRACE) << "onFinish";
+	reader.close();
+	return true;
+}
+
+void KeyPointsSequence::openSequence() {
+	index = 0;
+	prefetch_end = 0;
+	next_publish = boost::posix_time::microsec_clock::universal_time();
+
+	try {
+		reader.open(prop_filename);
+		CLOG(LDEBUG) << "Loaded " << reader.size() << " frames of keypoints from " << prop_filename;
+	} catch (std::exception & ex) {
+		CLOG(LERROR) << "Could not load keypoints from file: " << prop_filename << " (" << ex.what() << ")";
+		reader.close();
+	}//: catch
+}
+
+bool KeyPointsSequence::timeToPublish() {
+	if (prop_fps <= 0)
+		return true;
+
+	boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+	if (now < next_publish)
+		return false;
+
+	boost::posix_time::time_duration period = boost::posix_time::microseconds((long)(1e6 / prop_fps));
+	next_publish += period;
+	// Do not try to catch up after a stall - restart the schedule instead.
+	if (next_publish < now)
+		next_publish = now + period;
+	return true;
+}
+
+void KeyPointsSequence::onLoad() {
+	CLOG(LTRACE) << "onLoad";
+
+	if (reload_flag) {
+		reload_flag = false;
+		openSequence();
+	}//: if
+
+	if (reader.size() == 0) {
+		CLOG(LDEBUG) << "Empty sequence!";
+		return;
+	}//: if
+
+	if (index >= reader.size()) {
+		if (!prop_loop)
+			return;
+		CLOG(LDEBUG) << "Loop";
+		index = 0;
+		prefetch_end = 0;
+	}//: if
+
+	if (!timeToPublish())
+		return;
+
+	// Keep the upcoming frames paged in - read ahead when the index enters the second half of the window.
+	int window = prop_prefetch_window;
+	if (window > 0 && index + window / 2 >= prefetch_end) {
+		reader.prefetch(index, window);
+		prefetch_end = index + window;
+	}//: if
+
+	Types::KeyPointsFrame frame = reader.frame(index);
+	CLOG(LDEBUG) << "Publishing frame " << index << " (" << frame.size() << " keypoints)";
+
+	// Single copy from the mapping into the published buffer.
+	Types::KeyPoints kps(std::vector<cv::KeyPoint>(frame.begin(), frame.end()));
+	out_keypoints.write(kps);
+
+	if (frame.hasDescriptors()) {
+		// Keypoints are copied into the reused buffer, descriptors into the (pooled) arena.
+		features.keypoints.assign(frame.begin(), frame.end());
+		features.setDescriptors(frame.descriptors());
+		out_features.write(features);
+	}//: if
+
+	++index;
+	if (index == reader.size()) {
+		out_end_of_sequence_trigger.write(Base::UnitType());
+		CLOG(LINFO) << "End of KeyPointsSequence";
+	}//: if
+}
+
+void KeyPointsSequence::onSequenceReload() {
+	CLOG(LDEBUG) << "onSequenceReload";
+	reload_flag = true;
+}
+
+bool KeyPointsSequence::onStart() {
+	return true;
+}
+
+bool KeyPointsSequence::onStop() {
+	return true;
+}
+
+
+}//: namespace KeyPointsSequence
+}//: namespace Sources
@@ -0,0 +1,145 @@
+/*!
+ * \file KeyPointsSequence.hpp
+ * \brief Class responsible for replaying keypoints recorded in binary keypoints files - class declaration.
+ */
+
+
+#ifndef KeyPointsSequence_HPP_
+#define KeyPointsSequence_HPP_
+
+#include "Component_Aux.hpp"
+#include "Component.hpp"
+#include "DataStream.hpp"
+#include "Property.hpp"
+
+#include "Types/KeyPoints.hpp"
+#include "Types/KeyPointsDescriptors.hpp"
+#include "Types/KeyPointsFile.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+/**
+ * \defgroup KeyPointsSequence KeyPointsSequence
+ *
+ * \brief Replays keypoints (with descriptors) recorded by KeyPointsRecorder.
+ */
+
+namespace Sources {
+namespace KeyPointsSequence {
+
+/*!
+ * \class KeyPointsSequence
+ * \brief Class responsible for replaying keypoints.
+ *
+ * The file is memory-mapped - frames are read directly from the mapping (the OS reads upcoming frames ahead),
+ * keypoints and descriptors are copied only once, into the published objects. Frames are published
+ * at the given rate or, if the rate is 0, on every step of the executor.
+ */
+class KeyPointsSequence : public Base::Component {
+
+public:
+	/*!
+	 * Constructor. Sets ID and startup variables.
+	 */
+	KeyPointsSequence(const std::string & name = "KeyPointsSequence");
+
+	/*!
+	 * Destructor.
+	 */
+	virtual ~KeyPointsSequence();
+
+	virtual void prepareInterface();
+
+protected:
+
+	/*!
+	 * Maps the file.
+	 */
+	bool onInit();
+
+	/*!
+	 * Unmaps the file.
+	 */
+	bool onFinish();
+
+	/*!
+	 * Start component
+	 */
+	bool onStart();
+
+	/*!
+	 * Stop component
+	 */
+	bool onStop();
+
+	/// Output data stream - keypoints.
+	Base::DataStreamOut <Types::KeyPoints> out_keypoints;
+
+	/// Output data stream - keypoints with descriptors (written only for frames containing descriptors).
+	Base::DataStreamOut <Types::KeyPointsDescriptors> out_features;
+
+	/// Output event - end of sequence.
+	Base::DataStreamOut<Base::UnitType> out_end_of_sequence_trigger;
+
+	/*!
+	 * Event handler function - publishes the next frame (if it is time to).
+	 */
+	void onLoad();
+
+	/*!
+	 * Event handler function - remaps the file, triggered manually.
+	 */
+	void onSequenceReload();
+
+private:
+	/*!
+	 * Maps the file, logs errors.
+	 */
+	void openSequence();
+
+	/*!
+	 * Checks whether the next frame should be published now, keeping the configured rate.
+	 */
+	bool timeToPublish();
+
+	/// Mapped keypoints file.
+	Types::KeyPointsFileReader reader;
+
+	/// Published keypoints with descriptors - its descriptor arena is reused whenever consumers have released it.
+	Types::KeyPointsDescriptors features;
+
+	/// Index of the next frame.
+	size_t index;
+
+	/// Frames [index, prefetch_end) were already requested to be read ahead.
+	size_t prefetch_end;
+
+	/// Time at which the next frame should be published.
+	boost::posix_time::ptime next_publish;
+
+	/// Reload flag.
+	bool reload_flag;
+
+
+	/// Keypoints file.
+	Base::Property<std::string> prop_filename;
+
+	/// Loop over the sequence.
+	Base::Property<bool> prop_loop;
+
+	/// Publishing rate in frames per second (0 - publish on every step).
+	Base::Property<double> prop_fps;
+
+	/// Number of frames read ahead.
+	Base::Property<int> prop_prefetch_window;
+};
+
+}//: namespace KeyPointsSequence
+}//: namespace Sources
+
+/*
+ * Register source component.
+ */
+REGISTER_COMPONENT("KeyPointsSequence", Sources::KeyPointsSequence::KeyPointsSequence)
+
+#endif /* KeyPointsSequence_HPP_ */
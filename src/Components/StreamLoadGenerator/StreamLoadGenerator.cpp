@@ -0,0 +1,130 @@
+/*!
+ * \file StreamLoadGenerator.cpp
+ * \brief Class responsible for generating synthetic high-rate streams - methods definition.
+ */
+
+#include "StreamLoadGenerator.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/bind.hpp>
+
+namespace Sources {
+namespace StreamLoadGenerator {
+
+StreamLoadGenerator::StreamLoadGenerator(const std::string & n) :
+	Base::Component(n),
+	prop_type("type", std::string("homogmatrix")),
+	prop_rate("rate", 1000),
+	prop_burst("burst", 100),
+	prop_keypoints("keypoints", 500)
+{
+	registerProperty(prop_type);
+	registerProperty(prop_rate);
+	registerProperty(prop_burst);
+	registerProperty(prop_keypoints);
+
+	CLOG(LTRACE) << "Constructed";
+}
+
+StreamLoadGenerator::~StreamLoadGenerator() {
+	CLOG(LTRACE) << "Destroyed";
+}
+
+
+void StreamLoadGenerator::prepareInterface() {
+	// Register streams.
+	registerStream("out_stamped_homogMatrix", &out_stamped_homogMatrix);
+	registerStream("out_stamped_camera_info", &out_stamped_camera_info);
+	registerStream("out_stamped_keypoints", &out_stamped_keypoints);
+
+	// Register handlers - sends messages, activated in every step.
+	registerHandler("generate_data", boost::bind(&StreamLoadGenerator::generate_data, this));
+	addDependency("generate_data", NULL);
+}
+
+bool StreamLoadGenerator::onInit() {
+	CLOG(LTRACE) << "initialize\n";
+
+	const std::string t = prop_type;
+	if (t == "camerainfo") {
+		type = CAMERAINFO;
+	} else if (t == "keypoints") {
+		type = KEYPOINTS;
+	} else {
+		if (t != "homogmatrix")
+			CLOG(LWARNING) << "Unknown message type " << t << ", homogmatrix used instead";
+		type = HOMOGMATRIX;
+	}//: else
+
+	// Pose of an object half a metre in front of the camera.
+	homogMatrix.payload()(2, 3) = 0.5;
+
+	camera_info.payload() = Types::CameraInfo(640, 480, 320, 240, 500, 500);
+
+	// Keypoints spread over a 640x480 image.
+	std::vector<cv::KeyPoint> & kps = keypoints.payload().keypoints;
+	kps.resize(std::max<int>(prop_keypoints, 0));
+	for (size_t i = 0; i < kps.size(); ++i)
+		kps[i] = cv::KeyPoint((float) ((i * 37) % 640), (float) ((i * 53) % 480), 7.0f);
+
+	sequence = 0;
+	start_time = 0;
+
+	return true;
+}
+
+bool StreamLoadGenerator::onFinish() {
+	CLOG(LTRACE) << "onFinish";
+	CLOG(LINFO) << "Sent " << sequence << " messages";
+	return true;
+}
+
+void StreamLoadGenerator::generate_data() {
+	const boost::int64_t now = Types::StreamStamp::now();
+	if (start_time == 0)
+		start_time = now;
+
+	boost::uint64_t count = std::max<int>(prop_burst, 1);
+	if (prop_rate > 0) {
+		// Messages due since the start, at most a burst of them in a single step.
+		const boost::uint64_t due = (boost::uint64_t) ((now - start_time) * 1e-9 * prop_rate) + 1;
+		count = (due > sequence) ? std::min(count, due - sequence) : 0;
+	}//: if
+
+	for (boost::uint64_t i = 0; i < count; ++i)
+		send();
+}
+
+void StreamLoadGenerator::send() {
+	// Send time is taken before the payload is written, so latency includes the whole hand-over of the payload.
+	const Types::StreamStamp stamp(sequence++, Types::StreamStamp::now());
+
+	switch (type) {
+	case HOMOGMATRIX:
+		homogMatrix.setStamp(stamp);
+		out_stamped_homogMatrix.write(homogMatrix);
+		break;
+	case CAMERAINFO:
+		camera_info.setStamp(stamp);
+		out_stamped_camera_info.write(camera_info);
+		break;
+	case KEYPOINTS:
+		keypoints.setStamp(stamp);
+		out_stamped_keypoints.write(keypoints);
+		break;
+	}//: switch
+}
+
+bool StreamLoadGenerator::onStart() {
+	return true;
+}
+
+bool StreamLoadGenerator::onStop() {
+	return true;
+}
+
+
+}//: namespace StreamLoadGenerator
+}//: namespace Sources
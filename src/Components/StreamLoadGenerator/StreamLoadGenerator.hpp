@@ -0,0 +1,136 @@
+/*!
+ * \file StreamLoadGenerator.hpp
+ * \brief Class responsible for generating synthetic high-rate streams - class declaration.
+ */
+
+
+#ifndef StreamLoadGenerator_HPP_
+#define StreamLoadGenerator_HPP_
+
+#include "Component_Aux.hpp"
+#include "Component.hpp"
+#include "DataStream.hpp"
+#include "Property.hpp"
+
+#include "Types/CameraInfo.hpp"
+#include "Types/HomogMatrix.hpp"
+#include "Types/KeyPoints.hpp"
+#include "Types/Stamped.hpp"
+#include "Types/StreamStamp.hpp"
+
+#include <string>
+
+#include <boost/cstdint.hpp>
+
+/**
+ * \defgroup StreamLoadGenerator StreamLoadGenerator
+ *
+ * \brief Emits HomogMatrix, CameraInfo or KeyPoints messages at a given rate, for throughput benchmarks (see ThroughputMeter).
+ */
+
+namespace Sources {
+namespace StreamLoadGenerator {
+
+/*!
+ * \class StreamLoadGenerator
+ * \brief Class responsible for generating synthetic streams.
+ *
+ * Every message is sent as Types::Stamped - the payload together with its Types::StreamStamp (sequence number
+ * and the time taken just before the message was written), so the payload itself is never modified.
+ * Payloads are prepared once, so the measured cost is the cost of the pipeline, not of the generator.
+ * Sending is paced by the target rate: in every step the generator sends the messages due since
+ * the start (at most burst of them - the rest is sent in the next steps). With rate 0 every step sends
+ * a full burst.
+ */
+class StreamLoadGenerator : public Base::Component {
+
+public:
+	/*!
+	 * Constructor. Sets ID and startup variables.
+	 */
+	StreamLoadGenerator(const std::string & name = "StreamLoadGenerator");
+
+	/*!
+	 * Destructor.
+	 */
+	virtual ~StreamLoadGenerator();
+
+	virtual void prepareInterface();
+
+protected:
+
+	/*!
+	 * Prepares the messages.
+	 */
+	bool onInit();
+
+	/*!
+	 * Logs the number of sent messages.
+	 */
+	bool onFinish();
+
+	/*!
+	 * Start component
+	 */
+	bool onStart();
+
+	/*!
+	 * Stop component
+	 */
+	bool onStop();
+
+	/// Output data streams - generated stamped messages (only the one of the selected type is used).
+	Base::DataStreamOut <Types::Stamped<Types::HomogMatrix> > out_stamped_homogMatrix;
+	Base::DataStreamOut <Types::Stamped<Types::CameraInfo> > out_stamped_camera_info;
+	Base::DataStreamOut <Types::Stamped<Types::KeyPoints> > out_stamped_keypoints;
+
+	/*!
+	 * Event handler function - sends the messages due.
+	 */
+	void generate_data();
+
+private:
+	/// Type of the messages.
+	enum MessageType { HOMOGMATRIX, CAMERAINFO, KEYPOINTS };
+
+	/*!
+	 * Sends a single stamped message.
+	 */
+	void send();
+
+	MessageType type;
+
+	/// Prepared messages, only their stamps change.
+	Types::Stamped<Types::HomogMatrix> homogMatrix;
+	Types::Stamped<Types::CameraInfo> camera_info;
+	Types::Stamped<Types::KeyPoints> keypoints;
+
+	/// Sequence number of the next message.
+	boost::uint64_t sequence;
+
+	/// Time of the first step [ns] (0 before the first step).
+	boost::int64_t start_time;
+
+
+	/// Type of the messages - homogmatrix, camerainfo or keypoints.
+	Base::Property<std::string> prop_type;
+
+	/// Target rate [messages per second], 0 - as fast as possible.
+	Base::Property<double> prop_rate;
+
+	/// Maximal number of messages sent in a single step.
+	Base::Property<int> prop_burst;
+
+	/// Number of keypoints in every KeyPoints message.
+	Base::Property<int> prop_keypoints;
+};
+
+}//: namespace StreamLoadGenerator
+}//: namespace Sources
+
+/*
+ * Register source component.
+ */
+REGISTER_COMPONENT("StreamLoadGenerator", Sources::StreamLoadGenerator::StreamLoadGenerator)
+
+#endif /* StreamLoadGenerator_HPP_ */
@@ -0,0 +1,143 @@
+/*!
+ * \file ThroughputMeter.cpp
+ * \brief Class responsible for measuring throughput, drops and latency of streams - methods definition.
+ */
+
+#include "ThroughputMeter.hpp"
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
+namespace Sinks {
+namespace ThroughputMeter {
+
+namespace {
+
+/// Returns the p-th percentile (p in [0, 1]) of the values, reorders them.
+double percentile(std::vector<boost::int64_t> & values_, double p_) {
+	if (values_.empty())
+		return 0;
+	const size_t k = std::min(values_.size() - 1, (size_t) (p_ * values_.size()));
+	std::nth_element(values_.begin(), values_.begin() + k, values_.end());
+	return (double) values_[k];
+}
+
+} //: namespace
+
+ThroughputMeter::ThroughputMeter(const std::string & n) :
+	Base::Component(n),
+	prop_report_interval("report_interval", 1.0)
+{
+	registerProperty(prop_report_interval);
+
+	CLOG(LTRACE) << "Constructed";
+}
+
+ThroughputMeter::~ThroughputMeter() {
+	CLOG(LTRACE) << "Destroyed";
+}
+
+
+void ThroughputMeter::prepareInterface() {
+	// Register streams.
+	registerStream("in_stamped_homogMatrix", &in_stamped_homogMatrix);
+	registerStream("in_stamped_camera_info", &in_stamped_camera_info);
+	registerStream("in_stamped_keypoints", &in_stamped_keypoints);
+	registerStream("out_throughput", &out_throughput);
+
+	// Register handlers - measure messages, activated when new messages arrive.
+	registerHandler("onNewHomogMatrix", boost::bind(&ThroughputMeter::onNewHomogMatrix, this));
+	addDependency("onNewHomogMatrix", &in_stamped_homogMatrix);
+
+	registerHandler("onNewCameraInfo", boost::bind(&ThroughputMeter::onNewCameraInfo, this));
+	addDependency("onNewCameraInfo", &in_stamped_camera_info);
+
+	registerHandler("onNewKeyPoints", boost::bind(&ThroughputMeter::onNewKeyPoints, this));
+	addDependency("onNewKeyPoints", &in_stamped_keypoints);
+}
+
+bool ThroughputMeter::onInit() {
+	CLOG(LTRACE) << "initialize\n";
+
+	interval_start = 0;
+	messages = drops = 0;
+	next_sequence = 0;
+	total_messages = total_drops = 0;
+	latencies.clear();
+	latencies.reserve(1 << 16);
+
+	return true;
+}
+
+bool ThroughputMeter::onFinish() {
+	CLOG(LTRACE) << "onFinish";
+
+	if (messages > 0 || drops > 0 || !latencies.empty())
+		report(Types::StreamStamp::now());
+	CLOG(LINFO) << "Received " << total_messages << " messages, " << total_drops << " dropped";
+	return true;
+}
+
+void ThroughputMeter::onNewHomogMatrix() {
+	received(in_stamped_homogMatrix.read().stamp());
+}
+
+void ThroughputMeter::onNewCameraInfo() {
+	received(in_stamped_camera_info.read().stamp());
+}
+
+void ThroughputMeter::onNewKeyPoints() {
+	received(in_stamped_keypoints.read().stamp());
+}
+
+void ThroughputMeter::received(const Types::StreamStamp & stamp_) {
+	const boost::int64_t now = Types::StreamStamp::now();
+	if (interval_start == 0)
+		interval_start = now;
+
+	++messages;
+	++total_messages;
+	latencies.push_back(now - stamp_.time());
+
+	// Messages between the expected and the received one were lost.
+	if (stamp_.sequence() > next_sequence) {
+		drops += stamp_.sequence() - next_sequence;
+		total_drops += stamp_.sequence() - next_sequence;
+	}//: if
+	if (stamp_.sequence() >= next_sequence)
+		next_sequence = stamp_.sequence() + 1;
+
+	if (now - interval_start >= prop_report_interval * 1e9)
+		report(now);
+}
+
+void ThroughputMeter::report(boost::int64_t now_) {
+	const double seconds = (interval_start > 0 && now_ > interval_start) ? (now_ - interval_start) * 1e-9 : 0;
+	const double throughput = (seconds > 0) ? messages / seconds : 0;
+
+	const double p50 = percentile(latencies, 0.5);
+	const double p90 = percentile(latencies, 0.9);
+	const double p99 = percentile(latencies, 0.99);
+	const double max = latencies.empty() ? 0 : (double) *std::max_element(latencies.begin(), latencies.end());
+
+	CLOG(LINFO) << throughput << " msg/s (" << messages << " in " << seconds << " s), " << drops << " dropped, latency [us]"
+			<< " p50 " << p50 * 1e-3 << " p90 " << p90 * 1e-3 << " p99 " << p99 * 1e-3 << " max " << max * 1e-3;
+	out_throughput.write(throughput);
+
+	interval_start = now_;
+	messages = drops = 0;
+	latencies.clear();
+}
+
+bool ThroughputMeter::onStart() {
+	return true;
+}
+
+bool ThroughputMeter::onStop() {
+	return true;
+}
+
+
+}//: namespace ThroughputMeter
+}//: namespace Sinks
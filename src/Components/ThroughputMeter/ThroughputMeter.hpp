@@ -0,0 +1,142 @@
+/*!
+ * \file ThroughputMeter.hpp
+ * \brief Class responsible for measuring throughput, drops and latency of streams - class declaration.
+ */
+
+
+#ifndef ThroughputMeter_HPP_
+#define ThroughputMeter_HPP_
+
+#include "Component_Aux.hpp"
+#include "Component.hpp"
+#include "DataStream.hpp"
+#include "Property.hpp"
+
+#include "Types/CameraInfo.hpp"
+#include "Types/HomogMatrix.hpp"
+#include "Types/KeyPoints.hpp"
+#include "Types/Stamped.hpp"
+#include "Types/StreamStamp.hpp"
+
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+/**
+ * \defgroup ThroughputMeter ThroughputMeter
+ *
+ * \brief Reports throughput, drops and latency percentiles of streams generated by StreamLoadGenerator.
+ */
+
+namespace Sinks {
+namespace ThroughputMeter {
+
+/*!
+ * \class ThroughputMeter
+ * \brief Class responsible for measuring streams.
+ *
+ * Stamped messages (Types::Stamped of any of the supported types) are counted as they arrive. Latency is
+ * the time from the send time of the stamp to the reception of the message; gaps of sequence numbers
+ * are counted as dropped messages.
+ *
+ * Every report_interval seconds (and when the task finishes) throughput, drops and 50th/90th/99th percentiles
+ * and maximum of the latency are logged; throughput is also written to out_throughput.
+ */
+class ThroughputMeter : public Base::Component {
+
+public:
+	/// Input buffers hold HomogMatrix instances, so the component must be allocated aligned.
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+	/*!
+	 * Constructor. Sets ID and startup variables.
+	 */
+	ThroughputMeter(const std::string & name = "ThroughputMeter");
+
+	/*!
+	 * Destructor.
+	 */
+	virtual ~ThroughputMeter();
+
+	virtual void prepareInterface();
+
+protected:
+
+	/*!
+	 * Resets the statistics.
+	 */
+	bool onInit();
+
+	/*!
+	 * Reports the rest of the statistics.
+	 */
+	bool onFinish();
+
+	/*!
+	 * Start component
+	 */
+	bool onStart();
+
+	/*!
+	 * Stop component
+	 */
+	bool onStop();
+
+	/// Input data streams - measured stamped messages.
+	Base::DataStreamIn <Types::Stamped<Types::HomogMatrix>, Base::DataStreamBuffer::Queue> in_stamped_homogMatrix;
+	Base::DataStreamIn <Types::Stamped<Types::CameraInfo>, Base::DataStreamBuffer::Queue> in_stamped_camera_info;
+	Base::DataStreamIn <Types::Stamped<Types::KeyPoints>, Base::DataStreamBuffer::Queue> in_stamped_keypoints;
+
+	/// Output data stream - messages per second in the last interval.
+	Base::DataStreamOut <double> out_throughput;
+
+	/*!
+	 * Event handler functions - measure the messages.
+	 */
+	void onNewHomogMatrix();
+	void onNewCameraInfo();
+	void onNewKeyPoints();
+
+private:
+	/*!
+	 * Counts the message, its latency and missing messages before it, reports if the interval passed.
+	 */
+	void received(const Types::StreamStamp & stamp_);
+
+	/*!
+	 * Logs and publishes statistics of the current interval and starts the next one.
+	 */
+	void report(boost::int64_t now_);
+
+	/// Start of the current interval [ns] (0 before the first message).
+	boost::int64_t interval_start;
+
+	/// Messages and drops in the current interval.
+	boost::uint64_t messages;
+	boost::uint64_t drops;
+
+	/// Latencies of the current interval [ns].
+	std::vector<boost::int64_t> latencies;
+
+	/// Sequence number of the next expected message.
+	boost::uint64_t next_sequence;
+
+	/// Totals.
+	boost::uint64_t total_messages;
+	boost::uint64_t total_drops;
+
+
+	/// Time between reports [s].
+	Base::Property<double> prop_report_interval;
+};
+
+}//: namespace ThroughputMeter
+}//: namespace Sinks
+
+/*
+ * Register sink component.
+ */
+REGISTER_COMPONENT("ThroughputMeter", Sinks::ThroughputMeter::ThroughputMeter)
+
+#endif /* ThroughputMeter_HPP_ */
@@ -0,0 +1,88 @@
+/*!
+ * \file calibration_database_builder.cpp
+ * \brief Merges calibration files of single cameras (as read by CameraInfoProvider) into one calibration database
+ * (see Types/CalibrationDatabase.hpp).
+ *
+ * Usage: calibration_database_builder <output.yml|output.xml> <id>:<width>x<height>:<calibration file> ...
+ *
+ * Camera matrix (M) and distortion coefficients (D) are required, R, P, ROT and T are copied if present.
+ * The first calibration of each camera becomes its default one.
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "Types/CalibrationDatabase.hpp"
+
+namespace {
+
+const char * MATRICES[] = { "M", "D", "R", "P", "ROT", "T" };
+
+void append(cv::FileStorage & out_, const std::string & spec_) {
+	const size_t first = spec_.find(':');
+	const size_t second = (first == std::string::npos) ? first : spec_.find(':', first + 1);
+	int width, height;
+	if (second == std::string::npos || first == 0
+			|| std::sscanf(spec_.substr(first + 1, second - first - 1).c_str(), "%dx%d", &width, &height) != 2
+			|| width <= 0 || height <= 0)
+		throw std::runtime_error("Invalid camera specification " + spec_ + " (expected id:WIDTHxHEIGHT:file)");
+
+	const std::string id = spec_.substr(0, first);
+	const std::string filename = spec_.substr(second + 1);
+	cv::FileStorage in(filename, cv::FileStorage::READ);
+	if (!in.isOpened())
+		throw std::runtime_error("Could not open " + filename);
+	if (in["M"].empty() || in["D"].empty())
+		throw std::runtime_error("No camera matrix or distortion coefficients in " + filename);
+
+	out_ << "{" << "id" << id << "width" << width << "height" << height;
+	for (size_t i = 0; i < sizeof(MATRICES) / sizeof(MATRICES[0]); ++i) {
+		cv::Mat m;
+		in[MATRICES[i]] >> m;
+		if (!m.empty())
+			out_ << MATRICES[i] << m;
+	}
+	out_ << "}";
+}
+
+} // namespace
+
+int main(int argc, char * argv[]) {
+	if (argc < 3) {
+		std::cerr << "Usage: " << argv[0] << " <output.yml|output.xml> <id>:<width>x<height>:<calibration file> ...\n";
+		return 1;
+	}
+
+	try {
+		{
+			cv::FileStorage out(argv[1], cv::FileStorage::WRITE);
+			if (!out.isOpened())
+				throw std::runtime_error(std::string("Could not create ") + argv[1]);
+			out << "cameras" << "[";
+			for (int i = 2; i < argc; ++i)
+				append(out, argv[i]);
+			out << "]";
+		}
+
+		// Validate the result - every calibration (all resolutions of every camera) must be decodable.
+		Types::CalibrationDatabase db(argv[1]);
+		const std::vector<std::string> ids = db.cameras();
+		for (size_t i = 0; i < ids.size(); ++i) {
+			const std::vector<cv::Size> sizes = db.resolutions(ids[i]);
+			for (size_t j = 0; j < sizes.size(); ++j)
+				db.get(ids[i], sizes[j].width, sizes[j].height);
+		}
+
+		std::cout << "Stored " << db.size() << " calibrations of " << ids.size() << " cameras in " << argv[1] << std::endl;
+	} catch (std::exception & ex) {
+		std::cerr << ex.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
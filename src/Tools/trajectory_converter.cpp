@@ -0,0 +1,57 @@
+/*!
+ * \file trajectory_converter.cpp
+ * \brief Converts XYZRPY sequences stored in YAML/XML files (as read by HomogenousMatrixSequence)
+ * into binary trajectory files (see Types/TrajectoryFile.hpp).
+ *
+ * Usage: trajectory_converter <input.yml|input.xml> <output>
+ *
+ * Poses are read from the XYZRPY node. If the optional timestamps node (column or row vector with one
+ * value per pose) is present, the trajectory is written with the timestamp column.
+ */
+
+#include <iostream>
+#include <stdexcept>
+
+#include <opencv2/core/core.hpp>
+
+#include "Types/TrajectoryFile.hpp"
+
+int main(int argc, char * argv[]) {
+	if (argc != 3) {
+		std::cerr << "Usage: " << argv[0] << " <input.yml|input.xml> <output>\n";
+		return 1;
+	}
+
+	try {
+		cv::FileStorage fs(argv[1], cv::FileStorage::READ);
+		if (!fs.isOpened())
+			throw std::runtime_error(std::string("Could not open ") + argv[1]);
+
+		cv::Mat matrices, timestamps;
+		fs["XYZRPY"] >> matrices;
+		if (!fs["timestamps"].empty())
+			fs["timestamps"] >> timestamps;
+		fs.release();
+
+		if (matrices.empty())
+			throw std::runtime_error(std::string("No XYZRPY poses in ") + argv[1]);
+		if (matrices.total() * matrices.channels() != (size_t)matrices.rows * 6 || matrices.depth() != CV_64F)
+			throw std::runtime_error("XYZRPY must be a matrix of doubles with six values per row");
+		if (!timestamps.empty() && (timestamps.total() != (size_t)matrices.rows || timestamps.depth() != CV_64F))
+			throw std::runtime_error("timestamps must contain one double per pose");
+
+		Types::TrajectoryWriter writer;
+		writer.open(argv[2], !timestamps.empty());
+		for (int i = 0; i < matrices.rows; ++i)
+			writer.append(*matrices.ptr<cv::Vec6d>(i), timestamps.empty() ? 0 : timestamps.at<double>(i));
+		writer.close();
+
+		std::cout << "Converted " << matrices.rows << " poses"
+				<< (timestamps.empty() ? "" : " with timestamps") << " to " << argv[2] << std::endl;
+	} catch (std::exception & ex) {
+		std::cerr << ex.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
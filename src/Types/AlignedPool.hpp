@@ -0,0 +1,229 @@
+/*!
+ * \file AlignedPool.hpp
+ * \brief Pool of cache-line aligned memory blocks and the STL allocator using it - for containers of Eigen-backed types.
+ */
+
+#ifndef ALIGNEDPOOL_HPP_
+#define ALIGNEDPOOL_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <limits>
+#include <list>
+#include <new>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "PoolSpinLock.hpp"
+
+namespace Types {
+
+/*!
+ * \class AlignedPool
+ * \brief Process-wide pool of memory blocks aligned to the cache line.
+ *
+ * Requests are rounded up to powers of two; released blocks are kept on per-size free lists and reused,
+ * so containers which are repeatedly filled and released (windows of poses, message buffers, descriptor
+ * arenas) do not hit the global allocator. Every size keeps up to MAX_CACHED_BYTES of released blocks,
+ * but at least two blocks, so at most 16 MB are cached in total. Blocks larger than MAX_BLOCK (1 MB) are
+ * allocated and freed directly. The alignment (64 bytes) satisfies every vectorised Eigen type,
+ * including AVX ones.
+ */
+class AlignedPool : private boost::noncopyable {
+public:
+	static const size_t ALIGNMENT = 64;
+
+	/// Smallest and largest pooled blocks (as powers of two).
+	static const int MIN_CLASS = 6;
+	static const int MAX_CLASS = 20;
+	static const size_t MAX_BLOCK = (size_t) 1 << MAX_CLASS;
+
+	/// Bytes of released blocks kept for reuse in every size class (at least two blocks are kept).
+	static const size_t MAX_CACHED_BYTES = (size_t) 1 << 20;
+
+	/// Returns the pool. The pool is never destroyed, so blocks can be released at any time, even at exit.
+	static AlignedPool & instance() {
+		static AlignedPool * pool = new AlignedPool;
+		return *pool;
+	}
+
+	/// Returns aligned block of at least bytes_ bytes. Throws std::bad_alloc.
+	void * allocate(size_t bytes_) {
+		const int c = sizeClass(bytes_);
+		if (c > MAX_CLASS)
+			return alignedMalloc(bytes_);
+
+		{
+			PoolSpinLock::Guard lock(locks[c - MIN_CLASS]);
+			std::vector<void *> & list = free_lists[c - MIN_CLASS];
+			if (!list.empty()) {
+				void * block = list.back();
+				list.pop_back();
+				return block;
+			}
+		}
+		return alignedMalloc((size_t) 1 << c);
+	}
+
+	/// Returns the size of the block allocate(bytes_) returns - all of it may be used.
+	static size_t blockSize(size_t bytes_) {
+		const int c = sizeClass(bytes_);
+		return (c > MAX_CLASS) ? bytes_ : ((size_t) 1 << c);
+	}
+
+	/// Releases the block returned by allocate(bytes_) (or by allocate(blockSize(bytes_))).
+	void deallocate(void * block_, size_t bytes_) {
+		if (!block_)
+			return;
+
+		const int c = sizeClass(bytes_);
+		if (c <= MAX_CLASS) {
+			const size_t limit = std::max<size_t>(2, MAX_CACHED_BYTES >> c);
+			PoolSpinLock::Guard lock(locks[c - MIN_CLASS]);
+			std::vector<void *> & list = free_lists[c - MIN_CLASS];
+			if (list.size() < limit) {
+				list.push_back(block_);
+				return;
+			}
+		}
+		alignedFree(block_);
+	}
+
+	/// Releases all cached blocks.
+	void trim() {
+		for (int c = 0; c < CLASSES; ++c) {
+			std::vector<void *> blocks;
+			{
+				PoolSpinLock::Guard lock(locks[c]);
+				blocks.swap(free_lists[c]);
+			}
+			for (size_t i = 0; i < blocks.size(); ++i)
+				alignedFree(blocks[i]);
+		}
+	}
+
+private:
+	static const int CLASSES = MAX_CLASS - MIN_CLASS + 1;
+
+	AlignedPool()
+	{
+	}
+
+	static int sizeClass(size_t bytes_) {
+		int c = MIN_CLASS;
+		while (c <= MAX_CLASS && ((size_t) 1 << c) < bytes_)
+			++c;
+		return c;
+	}
+
+	/// Allocates with malloc, storing the offset of the aligned block just before it.
+	static void * alignedMalloc(size_t bytes_) {
+		void * raw = std::malloc(bytes_ + ALIGNMENT);
+		if (!raw)
+			throw std::bad_alloc();
+		unsigned char * block = reinterpret_cast<unsigned char *>(
+				(reinterpret_cast<boost::uintptr_t>(raw) + ALIGNMENT) & ~(boost::uintptr_t) (ALIGNMENT - 1));
+		block[-1] = (unsigned char) (block - static_cast<unsigned char *>(raw));
+		return block;
+	}
+
+	static void alignedFree(void * block_) {
+		unsigned char * block = static_cast<unsigned char *>(block_);
+		std::free(block - block[-1]);
+	}
+
+	std::vector<void *> free_lists[CLASSES];
+	PoolSpinLock locks[CLASSES];
+};
+
+
+/*!
+ * \class AlignedPoolAllocator
+ * \brief STL allocator taking aligned blocks from the AlignedPool - use it for containers of fixed-size
+ * vectorisable Eigen types (e.g. HomogMatrix) instead of the default allocator.
+ */
+template <typename T>
+class AlignedPoolAllocator {
+public:
+	typedef T value_type;
+	typedef T * pointer;
+	typedef const T * const_pointer;
+	typedef T & reference;
+	typedef const T & const_reference;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+
+	template <typename U>
+	struct rebind {
+		typedef AlignedPoolAllocator<U> other;
+	};
+
+	AlignedPoolAllocator()
+	{
+	}
+
+	template <typename U>
+	AlignedPoolAllocator(const AlignedPoolAllocator<U> &)
+	{
+	}
+
+	pointer address(reference x_) const {
+		return &x_;
+	}
+
+	const_pointer address(const_reference x_) const {
+		return &x_;
+	}
+
+	pointer allocate(size_type n_, const void * = 0) {
+		if (n_ > max_size())
+			throw std::bad_alloc();
+		return static_cast<pointer>(AlignedPool::instance().allocate(n_ * sizeof(T)));
+	}
+
+	void deallocate(pointer p_, size_type n_) {
+		AlignedPool::instance().deallocate(p_, n_ * sizeof(T));
+	}
+
+	size_type max_size() const {
+		return std::numeric_limits<size_type>::max() / sizeof(T);
+	}
+
+	void construct(pointer p_, const T & v_) {
+		new (p_) T(v_);
+	}
+
+	void destroy(pointer p_) {
+		p_->~T();
+	}
+};
+
+template <typename T, typename U>
+inline bool operator==(const AlignedPoolAllocator<T> &, const AlignedPoolAllocator<U> &) {
+	return true;
+}
+
+template <typename T, typename U>
+inline bool operator!=(const AlignedPoolAllocator<T> &, const AlignedPoolAllocator<U> &) {
+	return false;
+}
+
+
+/*!
+ * \struct AlignedContainers
+ * \brief Standard containers of T using the AlignedPoolAllocator, e.g. AlignedContainers<HomogMatrix>::vector.
+ */
+template <typename T>
+struct AlignedContainers {
+	typedef std::vector<T, AlignedPoolAllocator<T> > vector;
+	typedef std::deque<T, AlignedPoolAllocator<T> > deque;
+	typedef std::list<T, AlignedPoolAllocator<T> > list;
+};
+
+} //: namespace Types
+
+#endif /* ALIGNEDPOOL_HPP_ */
@@ -0,0 +1,55 @@
+/*!
+ * \file AlignedPool_bench.cpp
+ * \brief Benchmark of containers of homogenous matrices - Eigen::aligned_allocator vs the pooled HomogMatrixVector.
+ *
+ * Every iteration builds a window of poses (as HomogenousMatrixSequence does in the batch mode),
+ * composes them and releases the window.
+ *
+ * Built when CvCoreTypes_BUILD_BENCHMARKS is enabled.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include <Eigen/StdVector>
+
+#include <opencv2/core/core.hpp>
+
+#include "HomogMatrix.hpp"
+#include "HomogMatrixContainers.hpp"
+
+namespace {
+
+const int ITERATIONS = 20000;
+
+template <typename Vector>
+void run(const char * name_, size_t window_) {
+	double checksum = 0;
+	bool aligned = true;
+	const int64 start = cv::getTickCount();
+	for (int it = 0; it < ITERATIONS; ++it) {
+		Vector poses(window_);
+		aligned = aligned && (reinterpret_cast<size_t>(&poses[0]) % 16 == 0);
+		for (size_t i = 0; i < window_; ++i)
+			poses[i].translation()(0) = (double) (it + i);
+		Types::HomogMatrixBaseType acc = Types::HomogMatrixBaseType::Identity();
+		for (size_t i = 0; i < window_; ++i)
+			acc = acc * poses[i];
+		checksum += acc.translation()(0);
+	}
+	const double t = (cv::getTickCount() - start) / cv::getTickFrequency();
+	printf("  %-26s %8.1f ns/pose %s (checksum %g)\n", name_, 1e9 * t / ((double) ITERATIONS * window_),
+			aligned ? "" : "MISALIGNED", checksum);
+}
+
+} // namespace
+
+int main() {
+	const size_t windows[] = { 16, 256, 4096 };
+	for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); ++w) {
+		printf("window of %lu poses\n", (unsigned long) windows[w]);
+		run<std::vector<Types::HomogMatrix, Eigen::aligned_allocator<Types::HomogMatrix> > >("Eigen::aligned_allocator", windows[w]);
+		run<Types::HomogMatrixVector>("HomogMatrixVector", windows[w]);
+	}
+	return 0;
+}
@@ -0,0 +1,235 @@
+/*!
+ * \file CalibrationDatabase.hpp
+ * \brief Single file holding calibrations of many cameras, indexed by camera id and resolution.
+ *
+ * File layout (YAML/XML readable by cv::FileStorage):
+ * \code
+ * cameras:
+ *    - { id: "left", width: 640, height: 480, M: !!opencv-matrix ..., D: !!opencv-matrix ... }
+ *    - { id: "left", width: 1280, height: 960, M: ..., D: ... }
+ *    - { id: "right", ... }
+ * \endcode
+ * M and D are required, R, P, ROT and T (as in CameraInfoProvider files) are optional.
+ */
+
+#ifndef CALIBRATIONDATABASE_HPP_
+#define CALIBRATIONDATABASE_HPP_
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <opencv2/core/core.hpp>
+
+#include "CameraInfo.hpp"
+
+namespace Types {
+
+/*!
+ * \class CalibrationDatabase
+ * \brief Index of calibrations stored in a single file.
+ *
+ * Opening the database parses the file once and builds the index (camera id, width, height) -> file node;
+ * matrices of a camera are decoded into a CameraInfo only when the camera is looked up for the first time.
+ * Lookups are O(1) (hash map) and thread-safe. Databases opened with shared() are shared by all users
+ * of the same file in the process, so many components serving cameras of one rig cost a single parse.
+ */
+class CalibrationDatabase : private boost::noncopyable {
+public:
+	typedef boost::shared_ptr<const CameraInfo> CameraInfoPtr;
+
+	/*!
+	 * Opens the database.
+	 * \throws std::runtime_error if the file cannot be opened or has no cameras sequence
+	 */
+	explicit CalibrationDatabase(const std::string & filename_) :
+		filename(filename_)
+	{
+		if (!fs.open(filename_, cv::FileStorage::READ))
+			throw std::runtime_error("Could not open calibration database " + filename_);
+
+		const cv::FileNode cameras = fs["cameras"];
+		if (!cameras.isSeq())
+			throw std::runtime_error("No cameras sequence in " + filename_);
+
+		for (cv::FileNodeIterator it = cameras.begin(); it != cameras.end(); ++it) {
+			const cv::FileNode node = *it;
+			const std::string id = (std::string) node["id"];
+			const Key key(id, (int) node["width"], (int) node["height"]);
+			if (id.empty() || key.width <= 0 || key.height <= 0)
+				throw std::runtime_error("Camera without id or resolution in " + filename_);
+
+			Entry & entry = entries[key];
+			if (!entry.node.empty())
+				throw std::runtime_error("Duplicate calibration of camera " + id + " in " + filename_);
+			entry.node = node;
+
+			// The first resolution listed is the default one.
+			if (defaults.find(id) == defaults.end())
+				defaults[id] = key;
+		}
+	}
+
+	/// Returns the database of the file, opening it only if no other user keeps it open.
+	static boost::shared_ptr<CalibrationDatabase> shared(const std::string & filename_) {
+		static boost::mutex registry_mutex;
+		static std::map<std::string, boost::weak_ptr<CalibrationDatabase> > registry;
+
+		boost::mutex::scoped_lock lock(registry_mutex);
+		boost::shared_ptr<CalibrationDatabase> db = registry[filename_].lock();
+		if (!db) {
+			db.reset(new CalibrationDatabase(filename_));
+			registry[filename_] = db;
+		}
+		return db;
+	}
+
+	/*!
+	 * Returns calibration of the camera in the given resolution (or in its default resolution if width_ and height_ are 0).
+	 * \returns NULL if there is no such calibration
+	 * \throws std::runtime_error if the calibration cannot be decoded
+	 */
+	CameraInfoPtr find(const std::string & id_, int width_ = 0, int height_ = 0) {
+		boost::mutex::scoped_lock lock(mutex);
+
+		Key key(id_, width_, height_);
+		if (width_ == 0 && height_ == 0) {
+			Defaults::const_iterator d = defaults.find(id_);
+			if (d == defaults.end())
+				return CameraInfoPtr();
+			key = d->second;
+		}
+
+		Entries::iterator it = entries.find(key);
+		if (it == entries.end())
+			return CameraInfoPtr();
+		if (!it->second.info)
+			it->second.info = decode(key, it->second.node);
+		return it->second.info;
+	}
+
+	/// Returns calibration of the camera, throws if there is none.
+	CameraInfoPtr get(const std::string & id_, int width_ = 0, int height_ = 0) {
+		CameraInfoPtr info = find(id_, width_, height_);
+		if (!info)
+			throw std::runtime_error("No calibration of camera " + id_ + " in " + filename);
+		return info;
+	}
+
+	/// Number of stored calibrations.
+	size_t size() const {
+		return entries.size();
+	}
+
+	/// Ids of the cameras (each listed once).
+	std::vector<std::string> cameras() const {
+		std::vector<std::string> ids;
+		for (Defaults::const_iterator it = defaults.begin(); it != defaults.end(); ++it)
+			ids.push_back(it->first);
+		return ids;
+	}
+
+	/// Resolutions the camera is calibrated in (in no particular order, empty for unknown cameras).
+	std::vector<cv::Size> resolutions(const std::string & id_) const {
+		std::vector<cv::Size> sizes;
+		for (Entries::const_iterator it = entries.begin(); it != entries.end(); ++it)
+			if (it->first.id == id_)
+				sizes.push_back(cv::Size(it->first.width, it->first.height));
+		return sizes;
+	}
+
+	const std::string & file() const {
+		return filename;
+	}
+
+private:
+	struct Key {
+		Key(const std::string & id_ = std::string(), int width_ = 0, int height_ = 0) :
+			id(id_), width(width_), height(height_)
+		{
+		}
+
+		bool operator==(const Key & other_) const {
+			return width == other_.width && height == other_.height && id == other_.id;
+		}
+
+		std::string id;
+		int width;
+		int height;
+	};
+
+	struct KeyHash {
+		size_t operator()(const Key & key_) const {
+			size_t seed = boost::hash_value(key_.id);
+			boost::hash_combine(seed, key_.width);
+			boost::hash_combine(seed, key_.height);
+			return seed;
+		}
+	};
+
+	struct Entry {
+		cv::FileNode node;
+		CameraInfoPtr info;
+	};
+
+	typedef boost::unordered_map<Key, Entry, KeyHash> Entries;
+	typedef boost::unordered_map<std::string, Key> Defaults;
+
+	/// Decodes the matrices (as single precision, as CameraInfo accessors expect).
+	static CameraInfoPtr decode(const Key & key_, const cv::FileNode & node_) {
+		boost::shared_ptr<CameraInfo> info(new CameraInfo(key_.width, key_.height));
+		cv::Mat m;
+
+		if (!readMatrix(node_["M"], m))
+			throw std::runtime_error("No camera matrix of camera " + key_.id);
+		info->setCameraMatrix(m);
+		if (!readMatrix(node_["D"], m))
+			throw std::runtime_error("No distortion coefficients of camera " + key_.id);
+		info->setDistCoeffs(m.reshape(1, 1));
+
+		if (readMatrix(node_["R"], m))
+			info->setRectificationMatrix(m);
+		if (readMatrix(node_["P"], m))
+			info->setProjectionMatrix(m);
+		if (readMatrix(node_["ROT"], m))
+			info->setRotationMatrix(m);
+		if (readMatrix(node_["T"], m))
+			info->setTranlationMatrix(m);
+		return info;
+	}
+
+	static bool readMatrix(const cv::FileNode & node_, cv::Mat & m_) {
+		if (node_.empty())
+			return false;
+		cv::Mat raw;
+		node_ >> raw;
+		if (raw.empty())
+			return false;
+		raw.convertTo(m_, CV_32F);
+		return true;
+	}
+
+	std::string filename;
+
+	/// Kept open - file nodes of not decoded cameras point into it.
+	cv::FileStorage fs;
+
+	Entries entries;
+
+	/// Default resolution of each camera.
+	Defaults defaults;
+
+	boost::mutex mutex;
+};
+
+} //: namespace Types
+
+#endif /* CALIBRATIONDATABASE_HPP_ */
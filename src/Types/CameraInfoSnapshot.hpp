@@ -0,0 +1,160 @@
+/*!
+ * \file CameraInfoSnapshot.hpp
+ * \brief Immutable snapshots of camera parameters, shared between threads.
+ */
+
+#ifndef CAMERAINFOSNAPSHOT_HPP_
+#define CAMERAINFOSNAPSHOT_HPP_
+
+#include <map>
+#include <string>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "CameraInfo.hpp"
+
+namespace Types {
+
+/*!
+ * \class CameraInfoSnapshot
+ * \brief Version of camera parameters - never modified once published.
+ *
+ * CameraInfo getters return Mat headers sharing the data, so the stored parameters are never handed out -
+ * info() returns a deep copy, which the caller may modify freely.
+ */
+class CameraInfoSnapshot {
+public:
+	CameraInfoSnapshot(const CameraInfo & info_, unsigned long version_) :
+		m_info(copyOf(info_)), m_version(version_)
+	{
+	}
+
+	/// Returns a deep copy of the parameters.
+	CameraInfo info() const {
+		return copyOf(m_info);
+	}
+
+	int width() const {
+		return m_info.width();
+	}
+
+	int height() const {
+		return m_info.height();
+	}
+
+	/// Number of the version, increasing with every publication.
+	unsigned long version() const {
+		return m_version;
+	}
+
+	/// Returns a copy of info_ not sharing any matrix with it (CameraInfo setters clone the matrices).
+	static CameraInfo copyOf(const CameraInfo & info_) {
+		CameraInfo copy(info_.width(), info_.height());
+		copy.setCameraMatrix(info_.cameraMatrix());
+		copy.setDistCoeffs(info_.distCoeffs());
+		copy.setRectificationMatrix(info_.rectificationMatrix());
+		copy.setProjectionMatrix(info_.projectionMatrix());
+		copy.setRotationMatrix(info_.rotationMatrix());
+		copy.setTranlationMatrix(info_.translationMatrix());
+		return copy;
+	}
+
+private:
+	/// Matrices are shared neither with the writer nor with the readers.
+	const CameraInfo m_info;
+	const unsigned long m_version;
+};
+
+typedef boost::shared_ptr<const CameraInfoSnapshot> CameraInfoSnapshotPtr;
+
+/*!
+ * \class SharedCameraInfo
+ * \brief Latest camera parameters, published by one writer and read by any thread (RCU style).
+ *
+ * The writer copies the parameters into a new immutable snapshot and swaps the pointer; readers copy
+ * the pointer only (boost::atomic_load - a reference count increment) and keep using their snapshot
+ * for as long as they need, whatever the writer does in the meantime.
+ * Old snapshots are freed when their last reader drops them.
+ *
+ * Holders are named, so threads outside of the components (and executors of other tasks) can get
+ * the parameters published e.g. by CameraInfoProvider (see its shared_name property).
+ *
+ * Every holder has at most one writer: it must claim the holder with attachWriter() before publishing,
+ * so two components configured with the same name cannot publish interleaved versions.
+ */
+class SharedCameraInfo : private boost::noncopyable {
+public:
+	SharedCameraInfo() :
+		writer(NULL), next_version(1)
+	{
+	}
+
+	/*!
+	 * Makes writer_ the only writer of the holder.
+	 * \return false if the holder is already claimed by another writer.
+	 */
+	bool attachWriter(const void * writer_) {
+		boost::mutex::scoped_lock lock(writer_mutex);
+		if (writer && writer != writer_)
+			return false;
+		writer = writer_;
+		return true;
+	}
+
+	/// Releases the holder, so another writer may claim it.
+	void detachWriter(const void * writer_) {
+		boost::mutex::scoped_lock lock(writer_mutex);
+		if (writer == writer_)
+			writer = NULL;
+	}
+
+	/// Returns the latest snapshot (NULL if nothing was published yet).
+	CameraInfoSnapshotPtr snapshot() const {
+		return boost::atomic_load(&current);
+	}
+
+	/// Publishes a copy of the parameters. May be called only by the attached writer, from one thread at once.
+	void publish(const CameraInfo & info_) {
+		CameraInfoSnapshotPtr snapshot(new CameraInfoSnapshot(info_, next_version++));
+		boost::atomic_store(&current, snapshot);
+	}
+
+	/// Returns the holder of the given name, creating it if needed. Holders live until the end of the process.
+	static SharedCameraInfo & get(const std::string & name_) {
+		Registry & r = registry();
+		boost::mutex::scoped_lock lock(r.mutex);
+		SharedCameraInfo *& holder = r.holders[name_];
+		if (!holder)
+			holder = new SharedCameraInfo;
+		return *holder;
+	}
+
+private:
+	struct Registry {
+		std::map<std::string, SharedCameraInfo *> holders;
+		boost::mutex mutex;
+	};
+
+	/// Never destroyed - readers may outlive static destructors of other translation units.
+	static Registry & registry() {
+		static Registry * r = new Registry;
+		return *r;
+	}
+
+	CameraInfoSnapshotPtr current;
+
+	/// Mutex guarding the writer.
+	boost::mutex writer_mutex;
+
+	/// Writer which claimed the holder (NULL if none).
+	const void * writer;
+
+	/// Used by the writer only.
+	unsigned long next_version;
+};
+
+} //: namespace Types
+
+#endif /* CAMERAINFOSNAPSHOT_HPP_ */
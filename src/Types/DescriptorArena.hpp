@@ -0,0 +1,169 @@
+/*!
+ * \file DescriptorArena.hpp
+ * \brief Aligned, reusable storage of feature descriptors backed by the process-wide AlignedPool.
+ */
+
+#ifndef DESCRIPTORARENA_HPP_
+#define DESCRIPTORARENA_HPP_
+
+#include <algorithm>
+#include <cstring>
+
+#include <opencv2/core/core.hpp>
+
+#include "AlignedPool.hpp"
+
+namespace Types {
+
+/*!
+ * \class DescriptorArena
+ * \brief Matrix of descriptors (one per row, CV_8U binary or CV_32F float) in a pooled, aligned block.
+ *
+ * Rows are padded to a multiple of 32 bytes and the padding is zeroed, so distance kernels can process whole
+ * 256-bit words without tail handling. Blocks (64-byte aligned) are taken from and given back to the AlignedPool.
+ * create() keeps the current block when it is large enough, so an arena filled every frame allocates only until
+ * it reaches its peak size.
+ */
+class DescriptorArena {
+public:
+	/// Row alignment in bytes.
+	static const size_t ROW_ALIGNMENT = 32;
+
+	/// Smallest block taken from the pool.
+	static const size_t MIN_BLOCK = 4096;
+
+	DescriptorArena() :
+		data(NULL), capacity_(0), rows_(0), cols_(0), type_(CV_8U), step_(0)
+	{
+	}
+
+	DescriptorArena(const DescriptorArena & other_) :
+		data(NULL), capacity_(0), rows_(0), cols_(0), type_(CV_8U), step_(0)
+	{
+		*this = other_;
+	}
+
+	DescriptorArena & operator=(const DescriptorArena & other_) {
+		if (this != &other_) {
+			reserveBytes(other_.rows_ * other_.step_);
+			rows_ = other_.rows_;
+			cols_ = other_.cols_;
+			type_ = other_.type_;
+			step_ = other_.step_;
+			if (rows_ > 0)
+				std::memcpy(data, other_.data, rows_ * step_);
+		}
+		return *this;
+	}
+
+	~DescriptorArena() {
+		AlignedPool::instance().deallocate(data, capacity_);
+	}
+
+	/// Prepares room for rows x cols descriptors of given type (CV_8U or CV_32F). Contents are zeroed.
+	void create(int rows_new_, int cols_new_, int type_new_) {
+		CV_Assert(type_new_ == CV_8U || type_new_ == CV_32F);
+		CV_Assert(rows_new_ >= 0 && cols_new_ >= 0);
+		const size_t elem = (type_new_ == CV_32F) ? sizeof(float) : sizeof(uchar);
+		const size_t step = (cols_new_ * elem + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+		reserveBytes(rows_new_ * step);
+		rows_ = rows_new_;
+		cols_ = cols_new_;
+		type_ = type_new_;
+		step_ = step;
+		if (rows_ > 0)
+			std::memset(data, 0, rows_ * step_);
+	}
+
+	/// Copies descriptors from the matrix (e.g. output of cv::DescriptorExtractor).
+	void assign(const cv::Mat & descriptors_) {
+		if (descriptors_.empty()) {
+			clear();
+			return;
+		}
+		CV_Assert(descriptors_.type() == CV_8U || descriptors_.type() == CV_32F);
+		create(descriptors_.rows, descriptors_.cols, descriptors_.type());
+		const size_t row_bytes = descriptors_.cols * descriptors_.elemSize();
+		for (int i = 0; i < rows_; ++i)
+			std::memcpy(ptr(i), descriptors_.ptr(i), row_bytes);
+	}
+
+	/// Removes all descriptors, the block is kept for reuse.
+	void clear() {
+		rows_ = 0;
+	}
+
+	/// Returns header of the descriptor matrix pointing to the arena (no copy) - valid until the arena is modified.
+	cv::Mat mat() const {
+		if (rows_ == 0)
+			return cv::Mat();
+		return cv::Mat(rows_, cols_, type_, data, step_);
+	}
+
+	uchar * ptr(int row_) {
+		return data + row_ * step_;
+	}
+
+	const uchar * ptr(int row_) const {
+		return data + row_ * step_;
+	}
+
+	template <typename T>
+	T * ptr(int row_) {
+		return reinterpret_cast<T *>(ptr(row_));
+	}
+
+	template <typename T>
+	const T * ptr(int row_) const {
+		return reinterpret_cast<const T *>(ptr(row_));
+	}
+
+	int rows() const {
+		return rows_;
+	}
+
+	int cols() const {
+		return cols_;
+	}
+
+	int type() const {
+		return type_;
+	}
+
+	bool empty() const {
+		return rows_ == 0;
+	}
+
+	/// Distance between rows in bytes (multiple of ROW_ALIGNMENT).
+	size_t step() const {
+		return step_;
+	}
+
+	/// Size of the current block in bytes.
+	size_t capacity() const {
+		return capacity_;
+	}
+
+private:
+	void reserveBytes(size_t bytes_) {
+		if (bytes_ <= capacity_)
+			return;
+		AlignedPool::instance().deallocate(data, capacity_);
+		data = NULL;
+		capacity_ = 0;
+		const size_t size = AlignedPool::blockSize(std::max(bytes_, (size_t) MIN_BLOCK));
+		data = static_cast<uchar *>(AlignedPool::instance().allocate(size));
+		capacity_ = size;
+	}
+
+	uchar * data;
+	size_t capacity_;
+	int rows_;
+	int cols_;
+	int type_;
+	size_t step_;
+};
+
+} //: namespace Types
+
+#endif /* DESCRIPTORARENA_HPP_ */
@@ -0,0 +1,346 @@
+/*!
+ * \file DescriptorMatcher.hpp
+ * \brief Brute-force matcher of descriptors stored in DescriptorArena - SIMD Hamming/L2 kernels,
+ * ratio test, cross-check and multi-threaded tiling.
+ */
+
+#ifndef DESCRIPTORMATCHER_HPP_
+#define DESCRIPTORMATCHER_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <stdint.h>
+
+#include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+
+#include <opencv2/core/core.hpp>
+
+#if defined(__AVX2__) || defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#include "DescriptorArena.hpp"
+#include "KeyPointsDescriptors.hpp"
+
+namespace Types {
+
+/*!
+ * Distance kernels. Lengths are whole padded rows of DescriptorArena (multiples of 32 bytes, 32-byte aligned),
+ * so there is no tail handling. Define __AVX2__ / __FMA__ (e.g. with -march=native) to enable SIMD versions.
+ */
+namespace DescriptorDistance {
+
+/// Hamming distance of binary descriptors.
+inline unsigned hamming(const uchar * a_, const uchar * b_, size_t bytes_) {
+#if defined(__AVX2__)
+	// Nibble popcount with a shuffle lookup table, byte counts summed into 64-bit lanes.
+	const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+			0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low = _mm256_set1_epi8(0x0f);
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i acc = zero;
+	for (size_t i = 0; i < bytes_; i += 32) {
+		const __m256i x = _mm256_xor_si256(_mm256_load_si256((const __m256i *) (a_ + i)),
+				_mm256_load_si256((const __m256i *) (b_ + i)));
+		const __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(x, low)),
+				_mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(x, 4), low)));
+		acc = _mm256_add_epi64(acc, _mm256_sad_epu8(cnt, zero));
+	}
+	return (unsigned) (_mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+			_mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3));
+#else
+	// 64-bit popcount (a single instruction with -mpopcnt).
+	const uint64_t * a = reinterpret_cast<const uint64_t *>(a_);
+	const uint64_t * b = reinterpret_cast<const uint64_t *>(b_);
+	unsigned sum = 0;
+	for (size_t i = 0; i < bytes_ / 8; ++i)
+		sum += __builtin_popcountll(a[i] ^ b[i]);
+	return sum;
+#endif
+}
+
+/// Squared Euclidean distance of float descriptors.
+inline float l2sqr(const float * a_, const float * b_, size_t n_) {
+#if defined(__AVX2__) && defined(__FMA__)
+	__m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+	size_t i = 0;
+	for (; i + 16 <= n_; i += 16) {
+		const __m256 d0 = _mm256_sub_ps(_mm256_load_ps(a_ + i), _mm256_load_ps(b_ + i));
+		const __m256 d1 = _mm256_sub_ps(_mm256_load_ps(a_ + i + 8), _mm256_load_ps(b_ + i + 8));
+		acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+		acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+	}
+	if (i < n_) {
+		const __m256 d0 = _mm256_sub_ps(_mm256_load_ps(a_ + i), _mm256_load_ps(b_ + i));
+		acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+	}
+	acc0 = _mm256_add_ps(acc0, acc1);
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+	return _mm_cvtss_f32(s);
+#else
+	float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	for (size_t i = 0; i < n_; i += 4) {
+		const float d0 = a_[i] - b_[i], d1 = a_[i + 1] - b_[i + 1];
+		const float d2 = a_[i + 2] - b_[i + 2], d3 = a_[i + 3] - b_[i + 3];
+		s0 += d0 * d0;
+		s1 += d1 * d1;
+		s2 += d2 * d2;
+		s3 += d3 * d3;
+	}
+	return (s0 + s1) + (s2 + s3);
+#endif
+}
+
+} //: namespace DescriptorDistance
+
+
+/*!
+ * \class BruteForceMatcher
+ * \brief Finds the nearest train descriptor for every query descriptor.
+ *
+ * Binary (CV_8U) descriptors are compared with Hamming distance, float (CV_32F) ones with L2 distance,
+ * reported distances are the same as those of cv::BFMatcher with NORM_HAMMING / NORM_L2.
+ * Train descriptors are processed in tiles fitting in L1/L2 cache, queries are split between worker threads
+ * started once and reused for all calls. After the first calls with the largest sets match() does not allocate.
+ */
+class BruteForceMatcher : private boost::noncopyable {
+public:
+	/// Creates matcher using given number of threads (0 - one per hardware thread).
+	explicit BruteForceMatcher(unsigned threads_ = 1) :
+		ratio(0), cross_check(false), max_distance(std::numeric_limits<float>::max()),
+		query(NULL), train(NULL), generation(0), pending(0), stop(false)
+	{
+		threads = threads_ ? threads_ : std::max(1u, boost::thread::hardware_concurrency());
+		train_best.resize(threads);
+	}
+
+	~BruteForceMatcher() {
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			stop = true;
+		}
+		work_ready.notify_all();
+		workers.join_all();
+	}
+
+	/// Enables Lowe's ratio test: a match is kept only if best < ratio * second best (0 disables the test).
+	void setRatio(float ratio_) {
+		ratio = ratio_;
+	}
+
+	/// Keeps only matches for which the query is also the nearest neighbour of the matched train descriptor.
+	void setCrossCheck(bool cross_check_) {
+		cross_check = cross_check_;
+	}
+
+	/// Drops matches with distance larger than given.
+	void setMaxDistance(float max_distance_) {
+		max_distance = max_distance_;
+	}
+
+	/// Matches query descriptors to train descriptors (both must have the same type and length).
+	void match(const DescriptorArena & query_, const DescriptorArena & train_, std::vector<cv::DMatch> & matches_) {
+		matches_.clear();
+		if (query_.empty() || train_.empty())
+			return;
+		CV_Assert(query_.type() == train_.type() && query_.cols() == train_.cols());
+
+		query = &query_;
+		train = &train_;
+		const int nq = query_.rows(), nt = train_.rows();
+		best.resize(nq);
+		if (cross_check) {
+			for (size_t w = 0; w < train_best.size(); ++w)
+				train_best[w].assign(nt, Candidate());
+		}
+
+		run();
+
+		// Reduce per-thread best queries of train descriptors (ties go to the lower query index).
+		if (cross_check) {
+			for (unsigned w = 1; w < threads; ++w)
+				for (int t = 0; t < nt; ++t)
+					if (train_best[w][t].distance < train_best[0][t].distance)
+						train_best[0][t] = train_best[w][t];
+		}
+
+		const bool l2 = (query_.type() == CV_32F);
+		// Distances of float descriptors are squared until here.
+		const float r = l2 ? ratio * ratio : ratio;
+		const float max_d = (l2 && max_distance < std::sqrt(std::numeric_limits<float>::max())) ?
+				max_distance * max_distance : max_distance;
+		matches_.reserve(nq);
+		for (int q = 0; q < nq; ++q) {
+			const Best & b = best[q];
+			if (b.index < 0 || b.first > max_d)
+				continue;
+			if (ratio > 0 && !(b.first < r * b.second))
+				continue;
+			if (cross_check && train_best[0][b.index].index != q)
+				continue;
+			matches_.push_back(cv::DMatch(q, b.index, l2 ? std::sqrt(b.first) : b.first));
+		}
+	}
+
+	/// Matches descriptors of two keypoint sets.
+	void match(const KeyPointsDescriptors & query_, const KeyPointsDescriptors & train_, std::vector<cv::DMatch> & matches_) {
+		match(query_.descriptors(), train_.descriptors(), matches_);
+	}
+
+private:
+	/// Two nearest train descriptors of a query.
+	struct Best {
+		float first;
+		float second;
+		int index;
+	};
+
+	/// Nearest query of a train descriptor.
+	struct Candidate {
+		Candidate() :
+			distance(std::numeric_limits<float>::max()), index(-1)
+		{
+		}
+
+		float distance;
+		int index;
+	};
+
+	/// Splits queries between threads and processes them.
+	void run() {
+		if (threads == 1) {
+			matchRange(0);
+			return;
+		}
+
+		boost::mutex::scoped_lock lock(mutex);
+		if (workers.size() == 0) {
+			for (unsigned w = 1; w < threads; ++w)
+				workers.create_thread(boost::bind(&BruteForceMatcher::workerLoop, this, w));
+		}
+		++generation;
+		pending = threads - 1;
+		work_ready.notify_all();
+		lock.unlock();
+
+		// The calling thread processes the first part of queries itself.
+		matchRange(0);
+
+		lock.lock();
+		while (pending > 0)
+			work_done.wait(lock);
+	}
+
+	void workerLoop(unsigned worker_) {
+		unsigned long seen = 0;
+		for (;;) {
+			{
+				boost::mutex::scoped_lock lock(mutex);
+				while (generation == seen && !stop)
+					work_ready.wait(lock);
+				if (stop)
+					return;
+				seen = generation;
+			}
+
+			matchRange(worker_);
+
+			boost::mutex::scoped_lock lock(mutex);
+			if (--pending == 0)
+				work_done.notify_one();
+		}
+	}
+
+	/// Processes queries assigned to the worker.
+	void matchRange(unsigned worker_) {
+		const int nq = query->rows();
+		const int chunk = (nq + threads - 1) / threads;
+		const int begin = std::min(nq, (int) worker_ * chunk);
+		const int end = std::min(nq, begin + chunk);
+		if (query->type() == CV_32F)
+			matchTiles<float>(worker_, begin, end);
+		else
+			matchTiles<uchar>(worker_, begin, end);
+	}
+
+	static float distance(const uchar * a_, const uchar * b_, size_t step_) {
+		return (float) DescriptorDistance::hamming(a_, b_, step_);
+	}
+
+	static float distance(const float * a_, const float * b_, size_t step_) {
+		return DescriptorDistance::l2sqr(a_, b_, step_ / sizeof(float));
+	}
+
+	template <typename T>
+	void matchTiles(unsigned worker_, int begin_, int end_) {
+		const float inf = std::numeric_limits<float>::max();
+		for (int q = begin_; q < end_; ++q) {
+			best[q].first = best[q].second = inf;
+			best[q].index = -1;
+		}
+
+		const size_t step = query->step();
+		const int nt = train->rows();
+		// Tile of train descriptors fitting in 32 kB.
+		const int tile = std::max<int>(16, (int) (32768 / step));
+		Candidate * tb = cross_check ? &train_best[worker_][0] : NULL;
+
+		for (int t0 = 0; t0 < nt; t0 += tile) {
+			const int t1 = std::min(nt, t0 + tile);
+			for (int q = begin_; q < end_; ++q) {
+				const T * qd = query->ptr<T>(q);
+				Best b = best[q];
+				for (int t = t0; t < t1; ++t) {
+					const float d = distance(qd, train->ptr<T>(t), step);
+					if (d < b.first) {
+						b.second = b.first;
+						b.first = d;
+						b.index = t;
+					} else if (d < b.second) {
+						b.second = d;
+					}
+					if (tb && d < tb[t].distance) {
+						tb[t].distance = d;
+						tb[t].index = q;
+					}
+				}
+				best[q] = b;
+			}
+		}
+	}
+
+	float ratio;
+	bool cross_check;
+	float max_distance;
+	unsigned threads;
+
+	/// Descriptors processed by the current call.
+	const DescriptorArena * query;
+	const DescriptorArena * train;
+
+	/// Two nearest train descriptors of every query.
+	std::vector<Best> best;
+
+	/// Nearest query of every train descriptor, separately for each thread.
+	std::vector<std::vector<Candidate> > train_best;
+
+	/// Worker threads and their synchronisation.
+	boost::thread_group workers;
+	boost::mutex mutex;
+	boost::condition_variable work_ready;
+	boost::condition_variable work_done;
+	unsigned long generation;
+	unsigned pending;
+	bool stop;
+};
+
+} //: namespace Types
+
+#endif /* DESCRIPTORMATCHER_HPP_ */
@@ -0,0 +1,130 @@
+/*!
+ * \file DescriptorMatcher_bench.cpp
+ * \brief Benchmark of Types::BruteForceMatcher against cv::BFMatcher - binary (ORB-like, 32 bytes)
+ * and float (SIFT-like, 128 floats) descriptors, plain, ratio test and cross-check matching.
+ *
+ * Configure with CvCoreTypes_NATIVE_ARCH to enable the AVX2/FMA kernels.
+ * Built when CvCoreTypes_BUILD_BENCHMARKS is enabled.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/features2d/features2d.hpp>
+
+#include "DescriptorMatcher.hpp"
+
+namespace {
+
+const int FRAMES = 20;
+const int DESCRIPTORS = 2000;
+
+double seconds(int64 start_) {
+	return (cv::getTickCount() - start_) / cv::getTickFrequency();
+}
+
+/// Random descriptors, train ones are noisy, shuffled copies of the query ones.
+void randomDescriptors(int type_, int cols_, cv::Mat & query_, cv::Mat & train_) {
+	query_.create(DESCRIPTORS, cols_, type_);
+	train_.create(DESCRIPTORS, cols_, type_);
+	for (int i = 0; i < DESCRIPTORS; ++i) {
+		const int j = (i * 7919) % DESCRIPTORS;
+		for (int c = 0; c < cols_; ++c) {
+			if (type_ == CV_8U) {
+				query_.ptr<uchar>(i)[c] = (uchar) (rand() % 256);
+			} else {
+				query_.ptr<float>(i)[c] = (float) (rand() % 256);
+			}
+		}
+		for (int c = 0; c < cols_; ++c) {
+			if (type_ == CV_8U) {
+				train_.ptr<uchar>(j)[c] = query_.ptr<uchar>(i)[c] ^ (uchar) ((rand() % 8) == 0);
+			} else {
+				train_.ptr<float>(j)[c] = query_.ptr<float>(i)[c] + (float) (rand() % 5);
+			}
+		}
+	}
+}
+
+void run(const char * name_, int type_, int cols_, int norm_, unsigned threads_) {
+	cv::Mat query, train;
+	randomDescriptors(type_, cols_, query, train);
+
+	std::vector<cv::DMatch> matches;
+	std::vector<std::vector<cv::DMatch> > knn;
+
+	// OpenCV - plain, ratio test (k-NN with k = 2) and cross-check.
+	cv::BFMatcher bf(norm_), bf_cross(norm_, true);
+	size_t cv_count[3] = { 0, 0, 0 };
+	int64 start = cv::getTickCount();
+	for (int f = 0; f < FRAMES; ++f) {
+		bf.match(query, train, matches);
+		cv_count[0] += matches.size();
+	}
+	double t_cv = seconds(start);
+	start = cv::getTickCount();
+	for (int f = 0; f < FRAMES; ++f) {
+		bf.knnMatch(query, train, knn, 2);
+		for (size_t i = 0; i < knn.size(); ++i)
+			cv_count[1] += (knn[i].size() == 2 && knn[i][0].distance < 0.8f * knn[i][1].distance);
+	}
+	double t_cv_ratio = seconds(start);
+	start = cv::getTickCount();
+	for (int f = 0; f < FRAMES; ++f) {
+		bf_cross.match(query, train, matches);
+		cv_count[2] += matches.size();
+	}
+	double t_cv_cross = seconds(start);
+
+	// Arena-based matcher, the same three variants.
+	Types::KeyPointsDescriptors q, t;
+	Types::BruteForceMatcher matcher(threads_);
+	size_t count[3] = { 0, 0, 0 };
+	start = cv::getTickCount();
+	for (int f = 0; f < FRAMES; ++f) {
+		// Refilling arenas every frame, as a feature extractor would.
+		q.setDescriptors(query);
+		t.setDescriptors(train);
+		matcher.match(q, t, matches);
+		count[0] += matches.size();
+	}
+	double t_arena = seconds(start);
+	matcher.setRatio(0.8f);
+	start = cv::getTickCount();
+	for (int f = 0; f < FRAMES; ++f) {
+		matcher.match(q, t, matches);
+		count[1] += matches.size();
+	}
+	double t_arena_ratio = seconds(start);
+	matcher.setRatio(0);
+	matcher.setCrossCheck(true);
+	start = cv::getTickCount();
+	for (int f = 0; f < FRAMES; ++f) {
+		matcher.match(q, t, matches);
+		count[2] += matches.size();
+	}
+	double t_arena_cross = seconds(start);
+
+	printf("%s, %d x %d descriptors, %u thread(s)\n", name_, DESCRIPTORS, DESCRIPTORS, threads_);
+	printf("  plain:       cv::BFMatcher %8.2f ms   arena %8.2f ms   (%zu / %zu matches)\n",
+			1e3 * t_cv / FRAMES, 1e3 * t_arena / FRAMES, cv_count[0], count[0]);
+	printf("  ratio test:  cv::BFMatcher %8.2f ms   arena %8.2f ms   (%zu / %zu matches)\n",
+			1e3 * t_cv_ratio / FRAMES, 1e3 * t_arena_ratio / FRAMES, cv_count[1], count[1]);
+	printf("  cross-check: cv::BFMatcher %8.2f ms   arena %8.2f ms   (%zu / %zu matches)\n",
+			1e3 * t_cv_cross / FRAMES, 1e3 * t_arena_cross / FRAMES, cv_count[2], count[2]);
+}
+
+}
+
+int main() {
+#if defined(__AVX2__)
+	printf("AVX2 kernels enabled\n");
+#endif
+	run("binary (32 bytes)", CV_8U, 32, cv::NORM_HAMMING, 1);
+	run("float (128)", CV_32F, 128, cv::NORM_L2, 1);
+	run("binary (32 bytes)", CV_8U, 32, cv::NORM_HAMMING, 0);
+	run("float (128)", CV_32F, 128, cv::NORM_L2, 0);
+	return 0;
+}
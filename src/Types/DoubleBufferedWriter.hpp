@@ -0,0 +1,146 @@
+/*!
+ * \file DoubleBufferedWriter.hpp
+ * \brief Front/back buffer pair with a background thread writing full buffers - used by recorders.
+ */
+
+#ifndef DOUBLEBUFFEREDWRITER_HPP_
+#define DOUBLEBUFFEREDWRITER_HPP_
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+
+namespace Types {
+
+/*!
+ * \class DoubleBufferedWriter
+ * \brief Hands buffers filled by one thread over to a writer thread, without ever waiting for it.
+ *
+ * The owning thread appends data to front(). swap() exchanges it with the back buffer only if the writer
+ * thread is idle - otherwise the front buffer simply keeps growing until the next swap. The writer thread
+ * passes every back buffer to the write function given to start() and clears it, keeping its capacity.
+ *
+ * Buffer may be any container with empty(), clear(), reserve() and swap() (e.g. std::vector).
+ * The write function is called on the writer thread (and on the calling thread by stop()) and must not throw.
+ */
+template <typename Buffer>
+class DoubleBufferedWriter : private boost::noncopyable {
+public:
+	typedef boost::function<void (const Buffer &)> WriteFunction;
+
+	DoubleBufferedWriter() :
+		stop_flag(false)
+	{
+	}
+
+	~DoubleBufferedWriter() {
+		stop();
+	}
+
+	/// Starts the writer thread, which passes full buffers to write_.
+	void start(const WriteFunction & write_) {
+		stop();
+		write = write_;
+		stop_flag = false;
+		writer_thread.reset(new boost::thread(boost::bind(&DoubleBufferedWriter::writerLoop, this)));
+	}
+
+	/// Stops the writer thread, then writes the rest of the front buffer in the calling thread.
+	void stop() {
+		if (writer_thread) {
+			{
+				boost::mutex::scoped_lock lock(buffer_mutex);
+				stop_flag = true;
+			}
+			buffer_ready.notify_one();
+			writer_thread->join();
+			writer_thread.reset();
+
+			if (!front_buffer.empty())
+				write(front_buffer);
+		}//: if
+		front_buffer.clear();
+	}
+
+	/// Returns true if the writer thread is running.
+	bool running() const {
+		return writer_thread.get() != NULL;
+	}
+
+	/// Buffer filled by the owning thread.
+	Buffer & front() {
+		return front_buffer;
+	}
+
+	/// Reserves space in both buffers.
+	void reserve(size_t size_) {
+		boost::mutex::scoped_lock lock(buffer_mutex);
+		front_buffer.reserve(size_);
+		back_buffer.reserve(size_);
+	}
+
+	/*!
+	 * Hands the front buffer over to the writer thread if it is idle.
+	 * \return false if the writer is still busy with the previous buffer.
+	 */
+	bool swap() {
+		if (front_buffer.empty())
+			return true;
+
+		{
+			boost::mutex::scoped_lock lock(buffer_mutex, boost::try_to_lock);
+			if (!lock.owns_lock() || !back_buffer.empty())
+				return false;
+			front_buffer.swap(back_buffer);
+		}
+		buffer_ready.notify_one();
+		return true;
+	}
+
+private:
+	/// Writer thread - writes back buffers.
+	void writerLoop() {
+		boost::mutex::scoped_lock lock(buffer_mutex);
+		for (;;) {
+			while (back_buffer.empty() && !stop_flag)
+				buffer_ready.wait(lock);
+
+			if (back_buffer.empty())
+				break;
+
+			// The buffer is owned by the writer until it is cleared - write it without holding the lock.
+			lock.unlock();
+			write(back_buffer);
+			lock.lock();
+
+			back_buffer.clear();
+		}//: for
+	}
+
+	/// Function writing a buffer.
+	WriteFunction write;
+
+	/// Thread writing the back buffer.
+	boost::scoped_ptr<boost::thread> writer_thread;
+
+	/// Mutex guarding back buffer and stop flag.
+	boost::mutex buffer_mutex;
+
+	/// Signals new back buffer or stop request.
+	boost::condition_variable buffer_ready;
+
+	/// Buffer filled by the owning thread.
+	Buffer front_buffer;
+
+	/// Buffer being written by the writer thread.
+	Buffer back_buffer;
+
+	/// Flag requesting the writer thread to finish.
+	bool stop_flag;
+};
+
+} //: namespace Types
+
+#endif /* DOUBLEBUFFEREDWRITER_HPP_ */
@@ -3,6 +3,8 @@
 
 #include <iostream>
 
+#include <boost/shared_ptr.hpp>
+
 #include <opencv2/core/core.hpp>
 
 namespace Types {
@@ -26,10 +28,30 @@ public:
 
 	virtual void draw(cv::Mat& image, cv::Scalar color, int offsetX = 0, int offsetY = 0) = 0;
 
+	/*!
+	 * Returns the rectangle containing all pixels touched by draw() with given offsets.
+	 * Empty rectangle means that the area is unknown (whole image may be affected).
+	 */
+	virtual cv::Rect bounds(int offsetX = 0, int offsetY = 0) const {
+		return cv::Rect();
+	}
+
 	virtual Drawable * clone() {
 		return NULL;
 	}
 
+	/*!
+	 * Returns ref-counted clone. Types with a DrawablePool (see DrawablePool.hpp) reuse pooled instances,
+	 * others wrap the result of clone().
+	 */
+	virtual boost::shared_ptr<Drawable> cloneHandle() {
+		return boost::shared_ptr<Drawable>(clone());
+	}
+
+	/// Releases data held by the object before it is returned to its pool - capacity of buffers may be kept.
+	virtual void recycle() {
+	}
+
 	void setCol(CvScalar col) {
 		m_col = col;
 	}
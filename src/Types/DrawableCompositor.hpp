@@ -0,0 +1,294 @@
+/*!
+ * \file DrawableCompositor.hpp
+ * \brief Renders all Drawables of a frame in a single pass into a reusable canvas, optionally in a worker thread.
+ */
+
+#ifndef DRAWABLECOMPOSITOR_HPP_
+#define DRAWABLECOMPOSITOR_HPP_
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <opencv2/core/core.hpp>
+
+#include "Drawable.hpp"
+
+namespace Types {
+
+/*!
+ * \class DrawableCompositor
+ * \brief Collects Drawables of a frame and renders them over the frame image.
+ *
+ * The frame is copied into a canvas kept between frames and all collected Drawables are drawn into it
+ * in one pass - the frame itself is never modified. Areas touched by Drawables (see Drawable::bounds())
+ * are tracked as dirty rectangles: if the background did not change since the canvas was last rendered
+ * (canvases rotate, so every canvas remembers the generation of the background it was rendered on),
+ * only the previously dirty areas are restored instead of copying the whole frame.
+ *
+ * In the threaded mode submit() only hands a copy of the frame over to the render worker and returns immediately
+ * (a frame which was not rendered yet is replaced by the newer one), so visualisation stays off the processing path
+ * and the caller may modify its frame right after the call. Rendered canvases are picked up with latest().
+ */
+class DrawableCompositor : private boost::noncopyable {
+public:
+	/// Maximal number of dirty rectangles - more rectangles are merged into their bounding box.
+	static const size_t MAX_DIRTY_RECTS = 32;
+
+	/// Creates compositor, the worker thread is started if requested.
+	explicit DrawableCompositor(bool threaded_ = false) :
+		generation(1), pending_changed(true), pending_ready(false), result_ready(false), stop(false)
+	{
+		if (threaded_)
+			worker.reset(new boost::thread(boost::bind(&DrawableCompositor::workerLoop, this)));
+	}
+
+	~DrawableCompositor() {
+		if (worker) {
+			{
+				boost::mutex::scoped_lock lock(mutex);
+				stop = true;
+			}
+			work_ready.notify_one();
+			worker->join();
+		}
+	}
+
+	/// Adds drawable to the current frame.
+	void add(const boost::shared_ptr<Drawable> & drawable_, const cv::Scalar & color_, int offsetX_ = 0, int offsetY_ = 0) {
+		if (!drawable_)
+			return;
+		Item item = { drawable_, color_, offsetX_, offsetY_ };
+		items.push_back(item);
+	}
+
+	/// Adds a (pooled) clone of the drawable to the current frame (drawables which cannot be cloned are skipped).
+	void add(Drawable & drawable_, const cv::Scalar & color_, int offsetX_ = 0, int offsetY_ = 0) {
+		add(drawable_.cloneHandle(), color_, offsetX_, offsetY_);
+	}
+
+	/// Drops drawables collected for the current frame.
+	void clear() {
+		items.clear();
+	}
+
+	/// Number of drawables collected for the current frame.
+	size_t size() const {
+		return items.size();
+	}
+
+	/*!
+	 * Renders collected drawables over the background in the calling thread and starts a new frame.
+	 * \param background_changed_ false if the background has the same contents as in the previous call
+	 * \returns canvas, valid until the next call
+	 * \throws std::logic_error in the threaded mode, where the canvas belongs to the worker (use submit())
+	 */
+	const cv::Mat & render(const cv::Mat & background_, bool background_changed_ = true) {
+		if (worker)
+			throw std::logic_error("DrawableCompositor::render() cannot be used in the threaded mode, use submit().");
+		renderInto(canvas, background_, background_changed_, items);
+		items.clear();
+		return canvas.image;
+	}
+
+	/// Dirty rectangles of the canvas returned by the last render().
+	const std::vector<cv::Rect> & dirtyRects() const {
+		return canvas.dirty;
+	}
+
+	/*!
+	 * Renders the background and collected drawables (handed over to the worker in the threaded mode)
+	 * and starts a new frame. Never waits for the worker.
+	 */
+	void submit(const cv::Mat & background_, bool background_changed_ = true) {
+		if (!worker) {
+			render(background_, background_changed_);
+			boost::mutex::scoped_lock lock(mutex);
+			canvas.swap(done);
+			result_ready = true;
+			return;
+		}
+
+		// The worker renders from a copy, as the caller may reuse its frame buffer. The copy is made outside
+		// of the lock into a buffer owned by this thread and then exchanged with the pending one.
+		background_.copyTo(staged_background);
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			// Unrendered frame is replaced, but its background change must not be forgotten.
+			pending_changed = background_changed_ || (pending_ready && pending_changed);
+			std::swap(pending_background, staged_background);
+			pending_items.swap(items);
+			pending_ready = true;
+		}
+		items.clear();
+		work_ready.notify_one();
+	}
+
+	/*!
+	 * Returns the most recently rendered canvas (header, no copy) - valid until the next call of latest().
+	 * \returns false if no new canvas was rendered since the last call
+	 */
+	bool latest(cv::Mat & image_) {
+		boost::mutex::scoped_lock lock(mutex);
+		if (!result_ready)
+			return false;
+		done.swap(front);
+		result_ready = false;
+		image_ = front.image;
+		return true;
+	}
+
+private:
+	/// Drawable with its drawing parameters.
+	struct Item {
+		boost::shared_ptr<Drawable> drawable;
+		cv::Scalar color;
+		int offsetX;
+		int offsetY;
+	};
+
+	/// Rendered image with the areas covered by drawables.
+	struct Canvas {
+		Canvas() :
+			generation(0)
+		{
+		}
+
+		/// Exchanges canvases without copying the dirty rectangles.
+		void swap(Canvas & other_) {
+			std::swap(image, other_.image);
+			dirty.swap(other_.dirty);
+			std::swap(generation, other_.generation);
+		}
+
+		cv::Mat image;
+
+		/// Areas differing from the background.
+		std::vector<cv::Rect> dirty;
+
+		/// Generation of the background the canvas was rendered on (0 - never rendered).
+		unsigned long generation;
+	};
+
+	/// Renders the items into the canvas - called only by the thread rendering canvases (caller or worker).
+	void renderInto(Canvas & canvas_, const cv::Mat & background_, bool changed_, const std::vector<Item> & items_) {
+		const cv::Rect full(0, 0, background_.cols, background_.rows);
+		if (changed_)
+			++generation;
+		const bool same = canvas_.generation == generation && canvas_.image.size() == background_.size()
+				&& canvas_.image.type() == background_.type();
+		if (same) {
+			// Restore only the areas drawn over in the previous frame.
+			for (size_t i = 0; i < canvas_.dirty.size(); ++i)
+				background_(canvas_.dirty[i]).copyTo(canvas_.image(canvas_.dirty[i]));
+		} else {
+			// Reuses the canvas buffer if the size and type did not change.
+			background_.copyTo(canvas_.image);
+		}
+		canvas_.generation = generation;
+		canvas_.dirty.clear();
+
+		for (size_t i = 0; i < items_.size(); ++i) {
+			const Item & item = items_[i];
+			cv::Rect r = item.drawable->bounds(item.offsetX, item.offsetY);
+			// Unknown area - assume the whole image.
+			r = (r.area() > 0) ? (r & full) : full;
+			if (r.area() > 0)
+				addDirty(canvas_.dirty, r);
+			item.drawable->draw(canvas_.image, item.color, item.offsetX, item.offsetY);
+		}
+	}
+
+	/// Adds rectangle to the list, merging it with overlapping ones.
+	static void addDirty(std::vector<cv::Rect> & dirty_, cv::Rect r_) {
+		for (bool merged = true; merged; ) {
+			merged = false;
+			for (size_t i = 0; i < dirty_.size(); ++i) {
+				if ((dirty_[i] & r_).area() > 0) {
+					r_ |= dirty_[i];
+					dirty_[i] = dirty_.back();
+					dirty_.pop_back();
+					merged = true;
+					break;
+				}
+			}
+		}
+		dirty_.push_back(r_);
+
+		if (dirty_.size() > MAX_DIRTY_RECTS) {
+			for (size_t i = 1; i < dirty_.size(); ++i)
+				dirty_[0] |= dirty_[i];
+			dirty_.resize(1);
+		}
+	}
+
+	void workerLoop() {
+		std::vector<Item> work_items;
+		cv::Mat background;
+		bool changed;
+		for (;;) {
+			{
+				boost::mutex::scoped_lock lock(mutex);
+				while (!pending_ready && !stop)
+					work_ready.wait(lock);
+				if (stop)
+					return;
+				work_items.swap(pending_items);
+				// Gives the previously rendered background back for reuse by submit().
+				std::swap(background, pending_background);
+				changed = pending_changed;
+				pending_ready = false;
+			}
+
+			renderInto(canvas, background, changed, work_items);
+			work_items.clear();
+
+			boost::mutex::scoped_lock lock(mutex);
+			canvas.swap(done);
+			result_ready = true;
+		}
+	}
+
+	/// Drawables of the current frame.
+	std::vector<Item> items;
+
+	/// Canvas being rendered (by render() or the worker).
+	Canvas canvas;
+
+	/// Most recently rendered canvas, not picked up yet.
+	Canvas done;
+
+	/// Canvas returned by latest().
+	Canvas front;
+
+	/// Generation of the current background, incremented whenever it changes.
+	unsigned long generation;
+
+	/// Frame handed over to the worker.
+	std::vector<Item> pending_items;
+	cv::Mat pending_background;
+
+	/// Copy of the submitted background, used only by the thread calling submit().
+	cv::Mat staged_background;
+	bool pending_changed;
+	bool pending_ready;
+
+	/// Flag indicating that the done canvas is newer than the front one.
+	bool result_ready;
+
+	/// Worker thread and its synchronisation.
+	boost::scoped_ptr<boost::thread> worker;
+	boost::mutex mutex;
+	boost::condition_variable work_ready;
+	bool stop;
+};
+
+} //: namespace Types
+
+#endif /* DRAWABLECOMPOSITOR_HPP_ */
@@ -0,0 +1,209 @@
+/*!
+ * \file DrawablePool.hpp
+ * \brief Per-type pools of Drawables, used to create ref-counted clones without hitting the global allocator.
+ */
+
+#ifndef DRAWABLEPOOL_HPP_
+#define DRAWABLEPOOL_HPP_
+
+#include <cstddef>
+#include <new>
+#include <typeinfo>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "Drawable.hpp"
+#include "PoolSpinLock.hpp"
+
+namespace Types {
+
+/*!
+ * \class DrawablePool
+ * \brief Pool of released instances of a single Drawable type.
+ *
+ * clone() takes a released instance (if there is any) and copy-assigns the source to it, so vectors inside
+ * the instance reuse their capacity. The returned handle gives the instance back to the pool when the last
+ * reference is dropped; blocks of reference counters are recycled by the pool as well.
+ * T must be copy-constructible and copy-assignable.
+ */
+template <typename T>
+class DrawablePool : private boost::noncopyable {
+public:
+	/// Maximal number of released instances kept in the pool.
+	static const size_t MAX_FREE = 64;
+
+	/// Returns the pool of type T. The pool is never destroyed, so handles can be released at any time, even at exit.
+	static DrawablePool & instance() {
+		static DrawablePool * pool = new DrawablePool;
+		return *pool;
+	}
+
+	/// Returns ref-counted copy of the source object.
+	static boost::shared_ptr<T> clone(const T & source_) {
+		return instance().acquire(source_);
+	}
+
+	/*!
+	 * Implementation of T::cloneHandle(). Objects of classes derived from T which do not override cloneHandle()
+	 * are cloned with their virtual clone() instead, so they are never sliced to T.
+	 */
+	static boost::shared_ptr<Drawable> cloneHandle(T & source_) {
+		if (typeid(source_) != typeid(T))
+			return boost::shared_ptr<Drawable>(source_.clone());
+		return instance().acquire(source_);
+	}
+
+	/// Returns ref-counted copy of the source object.
+	boost::shared_ptr<T> acquire(const T & source_) {
+		T * obj = NULL;
+		{
+			PoolSpinLock::Guard lock(mutex);
+			if (!free.empty()) {
+				obj = free.back();
+				free.pop_back();
+			}
+		}
+		if (obj)
+			*obj = source_;
+		else
+			obj = new T(source_);
+		return boost::shared_ptr<T>(obj, Deleter(), Allocator());
+	}
+
+	/// Number of released instances waiting for reuse.
+	size_t available() {
+		PoolSpinLock::Guard lock(mutex);
+		return free.size();
+	}
+
+private:
+	/// Allocator of reference counters - single blocks are taken from the pool's free list.
+	template <typename U>
+	struct CounterAllocator {
+		typedef U value_type;
+		typedef U * pointer;
+		typedef const U * const_pointer;
+		typedef U & reference;
+		typedef const U & const_reference;
+		typedef std::size_t size_type;
+		typedef std::ptrdiff_t difference_type;
+
+		template <typename V>
+		struct rebind {
+			typedef CounterAllocator<V> other;
+		};
+
+		CounterAllocator()
+		{
+		}
+
+		template <typename V>
+		CounterAllocator(const CounterAllocator<V> &)
+		{
+		}
+
+		pointer allocate(size_type n_, const void * = 0) {
+			void * block = (n_ == 1) ? DrawablePool::instance().popCounter(sizeof(U)) : NULL;
+			return static_cast<pointer>(block ? block : ::operator new(n_ * sizeof(U)));
+		}
+
+		void deallocate(pointer p_, size_type n_) {
+			if (n_ != 1 || !DrawablePool::instance().pushCounter(p_, sizeof(U)))
+				::operator delete(p_);
+		}
+
+		void construct(pointer p_, const U & v_) {
+			new (p_) U(v_);
+		}
+
+		void destroy(pointer p_) {
+			p_->~U();
+		}
+
+		size_type max_size() const {
+			return size_type(-1) / sizeof(U);
+		}
+
+		pointer address(reference r_) const {
+			return &r_;
+		}
+
+		const_pointer address(const_reference r_) const {
+			return &r_;
+		}
+
+		template <typename V>
+		bool operator==(const CounterAllocator<V> &) const {
+			return true;
+		}
+
+		template <typename V>
+		bool operator!=(const CounterAllocator<V> &) const {
+			return false;
+		}
+	};
+
+	typedef CounterAllocator<T> Allocator;
+
+	/// Gives the object back to the pool.
+	struct Deleter {
+		void operator()(T * obj_) const {
+			DrawablePool::instance().release(obj_);
+		}
+	};
+
+	DrawablePool() :
+		counter_size(0)
+	{
+		free.reserve(MAX_FREE);
+		counters.reserve(MAX_FREE);
+	}
+
+	/// Returns released counter block of given size, NULL if there is none.
+	void * popCounter(size_t size_) {
+		PoolSpinLock::Guard lock(mutex);
+		if (counters.empty() || counter_size != size_)
+			return NULL;
+		void * block = counters.back();
+		counters.pop_back();
+		return block;
+	}
+
+	/// Keeps the counter block for reuse, returns false if the pool is full.
+	bool pushCounter(void * block_, size_t size_) {
+		PoolSpinLock::Guard lock(mutex);
+		if (counters.size() >= MAX_FREE || (counter_size != 0 && counter_size != size_))
+			return false;
+		counter_size = size_;
+		counters.push_back(block_);
+		return true;
+	}
+
+	void release(T * obj_) {
+		// Drop the data, but keep the capacity of buffers.
+		obj_->recycle();
+		{
+			PoolSpinLock::Guard lock(mutex);
+			if (free.size() < MAX_FREE) {
+				free.push_back(obj_);
+				return;
+			}
+		}
+		delete obj_;
+	}
+
+	PoolSpinLock mutex;
+
+	/// Released instances.
+	std::vector<T *> free;
+
+	/// Released blocks of reference counters (all of the same size).
+	std::vector<void *> counters;
+	size_t counter_size;
+};
+
+} //: namespace Types
+
+#endif /* DRAWABLEPOOL_HPP_ */
@@ -0,0 +1,114 @@
+/*!
+ * \file DrawablePool_bench.cpp
+ * \brief Benchmark of Drawable cloning - raw clone() / delete, clone() wrapped in boost::shared_ptr
+ * and pooled, ref-counted cloneHandle().
+ *
+ * Every frame each of the consumers clones the Drawable and drops the clone before the next frame.
+ * Allocations are counted by replacing the global operator new.
+ *
+ * Built when CvCoreTypes_BUILD_BENCHMARKS is enabled.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <opencv2/core/core.hpp>
+
+#include "KeyPoints.hpp"
+#include "SharedKeyPoints.hpp"
+#include "Objects3D/Chessboard.hpp"
+
+namespace {
+
+const int FRAMES = 50000;
+const int CONSUMERS = 4;
+
+/// Number of calls of the global operator new.
+size_t allocations = 0;
+
+double seconds(int64 start_) {
+	return (cv::getTickCount() - start_) / cv::getTickFrequency();
+}
+
+void report(const char * name_, double time_, size_t allocations_) {
+	const double clones = (double) FRAMES * CONSUMERS;
+	printf("  %-22s %8.1f ns/clone  %6.2f allocations/clone\n", name_, 1e9 * time_ / clones, allocations_ / clones);
+}
+
+void run(const char * name_, Types::Drawable & source_) {
+	printf("%s\n", name_);
+
+	// Raw clones.
+	std::vector<Types::Drawable *> raw;
+	raw.reserve(CONSUMERS);
+	size_t alloc_start = allocations;
+	int64 start = cv::getTickCount();
+	for (int f = 0; f < FRAMES; ++f) {
+		for (int c = 0; c < CONSUMERS; ++c)
+			raw.push_back(source_.clone());
+		for (size_t i = 0; i < raw.size(); ++i)
+			delete raw[i];
+		raw.clear();
+	}
+	report("clone()", seconds(start), allocations - alloc_start);
+
+	// Raw clones owned by shared pointers.
+	std::vector<boost::shared_ptr<Types::Drawable> > handles;
+	handles.reserve(CONSUMERS);
+	alloc_start = allocations;
+	start = cv::getTickCount();
+	for (int f = 0; f < FRAMES; ++f) {
+		for (int c = 0; c < CONSUMERS; ++c)
+			handles.push_back(boost::shared_ptr<Types::Drawable>(source_.clone()));
+		handles.clear();
+	}
+	report("shared_ptr(clone())", seconds(start), allocations - alloc_start);
+
+	// Pooled handles - warm the pool up first.
+	for (int c = 0; c < CONSUMERS; ++c)
+		handles.push_back(source_.cloneHandle());
+	handles.clear();
+
+	alloc_start = allocations;
+	start = cv::getTickCount();
+	for (int f = 0; f < FRAMES; ++f) {
+		for (int c = 0; c < CONSUMERS; ++c)
+			handles.push_back(source_.cloneHandle());
+		handles.clear();
+	}
+	report("cloneHandle()", seconds(start), allocations - alloc_start);
+}
+
+}
+
+void * operator new(size_t size_) {
+	++allocations;
+	void * p = std::malloc(size_ ? size_ : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void * p_) throw() {
+	std::free(p_);
+}
+
+int main() {
+	Types::KeyPoints keypoints(std::vector<cv::KeyPoint>(500));
+	Types::SharedKeyPoints shared_keypoints(keypoints);
+
+	Types::Objects3D::Chessboard chessboard(cv::Size(9, 6));
+	chessboard.setImagePoints(std::vector<cv::Point2f>(54, cv::Point2f(1, 2)));
+	chessboard.setModelPoints(std::vector<cv::Point3f>(54, cv::Point3f(1, 2, 0)));
+
+	printf("%d frames, %d consumers\n", FRAMES, CONSUMERS);
+	run("KeyPoints (500)", keypoints);
+	run("SharedKeyPoints (500)", shared_keypoints);
+	run("Chessboard (9x6)", chessboard);
+
+	return 0;
+}
@@ -0,0 +1,234 @@
+/*!
+ * \file HandlerStats.hpp
+ * \brief Lightweight, always-on statistics of component handlers - durations and published/skipped messages.
+ */
+
+#ifndef HANDLERSTATS_HPP_
+#define HANDLERSTATS_HPP_
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "StreamStamp.hpp"
+
+namespace Types {
+
+/*!
+ * \struct HandlerStatsSnapshot
+ * \brief Statistics of a handler at some moment (durations in microseconds).
+ */
+struct HandlerStatsSnapshot {
+	std::string name;
+
+	/// Number of calls, of calls which published a message and of calls which did not.
+	boost::uint64_t calls;
+	boost::uint64_t published;
+	boost::uint64_t skipped;
+
+	/// Mean and maximal duration.
+	double mean;
+	double max;
+
+	/// Percentiles of the duration (upper bounds of the histogram buckets).
+	double p50;
+	double p90;
+	double p99;
+};
+
+/// Statistics of all handlers of a component.
+typedef std::vector<HandlerStatsSnapshot> HandlerStatsReport;
+
+inline std::ostream & operator<<(std::ostream & os_, const HandlerStatsSnapshot & s_) {
+	os_ << s_.name << ": " << s_.calls << " calls (" << s_.published << " published, " << s_.skipped << " skipped), "
+			<< "mean " << s_.mean << " us, p50 <" << s_.p50 << " p90 <" << s_.p90 << " p99 <" << s_.p99
+			<< " max " << s_.max << " us";
+	return os_;
+}
+
+/*!
+ * \class HandlerStats
+ * \brief Durations of calls of a single handler.
+ *
+ * Durations are measured with the monotonic clock and counted in a histogram of log2 buckets
+ * (bucket i holds durations in [2^i, 2^(i+1)) ns). Updates are a few relaxed atomic increments,
+ * so statistics can stay enabled in production and be read (snapshot()) from any thread without locks.
+ * Percentiles are resolved to the bucket, i.e. up to a factor of 2.
+ */
+class HandlerStats : private boost::noncopyable {
+public:
+	static const int BUCKETS = 48;
+
+	/*!
+	 * \class Scope
+	 * \brief Measures the call from its construction to its destruction.
+	 *
+	 * Calls are counted as skipped unless published() is called.
+	 */
+	class Scope : private boost::noncopyable {
+	public:
+		explicit Scope(HandlerStats & stats_) :
+			stats(stats_), start(StreamStamp::now()), was_published(false)
+		{
+		}
+
+		~Scope() {
+			stats.record(StreamStamp::now() - start, was_published);
+		}
+
+		/// Marks the call as the one which published a message.
+		void published() {
+			was_published = true;
+		}
+
+	private:
+		HandlerStats & stats;
+		const boost::int64_t start;
+		bool was_published;
+	};
+
+	explicit HandlerStats(const std::string & name_) :
+		name(name_), calls(0), published(0), total(0), max(0)
+	{
+		for (int i = 0; i < BUCKETS; ++i)
+			histogram[i].store(0, boost::memory_order_relaxed);
+	}
+
+	/// Records a call lasting duration_ ns.
+	void record(boost::int64_t duration_, bool published_) {
+		const boost::uint64_t d = (duration_ > 0) ? (boost::uint64_t) duration_ : 0;
+		histogram[bucket(d)].fetch_add(1, boost::memory_order_relaxed);
+		total.fetch_add(d, boost::memory_order_relaxed);
+		if (published_)
+			published.fetch_add(1, boost::memory_order_relaxed);
+
+		boost::uint64_t m = max.load(boost::memory_order_relaxed);
+		while (d > m && !max.compare_exchange_weak(m, d, boost::memory_order_relaxed))
+			;
+
+		// Counted last - readers never see more calls than recorded durations.
+		calls.fetch_add(1, boost::memory_order_release);
+	}
+
+	HandlerStatsSnapshot snapshot() const {
+		HandlerStatsSnapshot s;
+		s.name = name;
+		s.calls = calls.load(boost::memory_order_acquire);
+		s.published = published.load(boost::memory_order_relaxed);
+		s.skipped = (s.calls > s.published) ? s.calls - s.published : 0;
+		s.mean = s.calls ? total.load(boost::memory_order_relaxed) * 1e-3 / s.calls : 0;
+		s.max = max.load(boost::memory_order_relaxed) * 1e-3;
+
+		boost::uint64_t counts[BUCKETS], sum = 0;
+		for (int i = 0; i < BUCKETS; ++i) {
+			counts[i] = histogram[i].load(boost::memory_order_relaxed);
+			sum += counts[i];
+		}
+		s.p50 = percentile(counts, sum, 0.5);
+		s.p90 = percentile(counts, sum, 0.9);
+		s.p99 = percentile(counts, sum, 0.99);
+		return s;
+	}
+
+	const std::string & getName() const {
+		return name;
+	}
+
+private:
+	static int bucket(boost::uint64_t d_) {
+#ifdef __GNUC__
+		return d_ ? std::min(63 - __builtin_clzll(d_), BUCKETS - 1) : 0;
+#else
+		int b = 0;
+		while (d_ > 1 && b < BUCKETS - 1) {
+			d_ >>= 1;
+			++b;
+		}
+		return b;
+#endif
+	}
+
+	/// Upper bound of the bucket holding the p-th percentile [us].
+	static double percentile(const boost::uint64_t * counts_, boost::uint64_t sum_, double p_) {
+		if (sum_ == 0)
+			return 0;
+		const boost::uint64_t rank = (boost::uint64_t) (p_ * (sum_ - 1)) + 1;
+		boost::uint64_t seen = 0;
+		for (int i = 0; i < BUCKETS; ++i) {
+			seen += counts_[i];
+			if (seen >= rank)
+				return (double) (2ULL << i) * 1e-3;
+		}
+		return (double) (2ULL << (BUCKETS - 1)) * 1e-3;
+	}
+
+	const std::string name;
+
+	boost::atomic<boost::uint64_t> calls;
+	boost::atomic<boost::uint64_t> published;
+
+	/// Sum and maximum of durations [ns].
+	boost::atomic<boost::uint64_t> total;
+	boost::atomic<boost::uint64_t> max;
+
+	boost::atomic<boost::uint64_t> histogram[BUCKETS];
+};
+
+/*!
+ * \class HandlerStatsGroup
+ * \brief Statistics of all instrumented handlers of a component, reported periodically.
+ */
+class HandlerStatsGroup : private boost::noncopyable {
+public:
+	HandlerStatsGroup() :
+		interval(0), last_report(0)
+	{
+	}
+
+	/// Adds statistics of a handler, must be called before the handlers run.
+	HandlerStats & add(const std::string & name_) {
+		stats.push_back(boost::shared_ptr<HandlerStats>(new HandlerStats(name_)));
+		return *stats.back();
+	}
+
+	/// Sets time between reports [s], 0 - never report.
+	void setInterval(double seconds_) {
+		interval = (boost::int64_t) (seconds_ * 1e9);
+		last_report = StreamStamp::now();
+	}
+
+	/// Returns true once per interval - to be checked by the thread running the handlers.
+	bool reportDue() {
+		if (interval <= 0)
+			return false;
+		const boost::int64_t now = StreamStamp::now();
+		if (now - last_report < interval)
+			return false;
+		last_report = now;
+		return true;
+	}
+
+	HandlerStatsReport snapshot() const {
+		HandlerStatsReport report;
+		report.reserve(stats.size());
+		for (size_t i = 0; i < stats.size(); ++i)
+			report.push_back(stats[i]->snapshot());
+		return report;
+	}
+
+private:
+	std::vector<boost::shared_ptr<HandlerStats> > stats;
+
+	boost::int64_t interval;
+	boost::int64_t last_report;
+};
+
+} //: namespace Types
+
+#endif /* HANDLERSTATS_HPP_ */
@@ -13,6 +13,8 @@
 #include <Eigen/LU>
 #include <opencv2/core/core.hpp>
 #include <opencv2/calib3d/calib3d.hpp>
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
 namespace Types {
@@ -21,10 +23,16 @@ namespace Types {
 typedef Eigen::Transform< double, 3, Eigen::Affine > HomogMatrixBaseType;
 typedef Eigen::Transform< double, 3, Eigen::AffineCompact > CompactHomogMatrixBaseType;
 
+/// Lazy composition of homogenous matrices - defined in HomogMatrixExpr.hpp.
+template <typename Derived> struct HomogMatrixExpr;
+
 
 /// Class representing homogenous matrix.
 struct HomogMatrix : public HomogMatrixBaseType
 {
+	/// Fixed-size vectorisable type - instances created with new (and objects holding them) must be aligned.
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
 	/// Base constructor - creates an identity matrix.
 	HomogMatrix() : HomogMatrixBaseType ( HomogMatrixBaseType::Identity ())
 	{
@@ -87,6 +95,14 @@ struct HomogMatrix : public HomogMatrixBaseType
 	}
 
 
+	/// Constructor evaluating the lazy chain of transforms (see HomogMatrixExpr.hpp) in a single pass.
+	template <typename Derived>
+	HomogMatrix(const HomogMatrixExpr<Derived> & expr_) :  HomogMatrixBaseType ( HomogMatrixBaseType::Identity ())
+	{
+		matrix().topRows<3>() = expr_.eval();
+	}
+
+
 	/// Constructor casting the Eigen 4x4 matrix with float to HomogMatrix (Eigen::Transform with doubles).
 //	HomogMatrix(Eigen::Matrix<float, 4, 4> mat_) {
 //		// Copy values from matrix.
@@ -145,6 +161,18 @@ struct HomogMatrix : public HomogMatrixBaseType
 	}
 
 
+	/// Method evaluates the lazy chain of transforms (see HomogMatrixExpr.hpp) and stores the result.
+	template <typename Derived>
+	HomogMatrix & operator = (const HomogMatrixExpr<Derived> & expr_)
+	{
+		// Evaluate first - the expression may refer to this matrix.
+		const Eigen::Matrix<double, 3, 4> tmp = expr_.eval();
+		matrix().topRows<3>() = tmp;
+		matrix().row(3) << 0, 0, 0, 1;
+		return *this;
+	}
+
+
 	/// Set transform on the basis of XYZ and RPY angles - arguments passed in a single vector.
 	void setFromXYZRPY(cv::Vec6d vec_)
 	{
@@ -167,6 +195,17 @@ struct HomogMatrix : public HomogMatrixBaseType
 
 
 
+	/// Returns translation and RPY angles (inverse of setFromXYZRPY, pitch in [-pi/2, pi/2]) in a single vector.
+	cv::Vec6d getXYZRPY() const
+	{
+		const Eigen::Matrix3d m = this->linear();
+		double roll = atan2(m(2,1), m(2,2));
+		double pitch = asin(std::max(-1.0, std::min(1.0, -m(2,0))));
+		double yaw = atan2(m(1,0), m(0,0));
+		return cv::Vec6d(this->translation()(0), this->translation()(1), this->translation()(2), roll, pitch, yaw);
+	}
+
+
 	/// Redirect the output stream.
 	inline friend ostream & operator<< (ostream &out_, HomogMatrix &hm_) {
 		cv::Matx44d tmp = hm_;
@@ -0,0 +1,21 @@
+/*!
+ * \file HomogMatrixContainers.hpp
+ * \brief Containers of homogenous matrices using the AlignedPoolAllocator.
+ */
+
+#ifndef HOMOGMATRIXCONTAINERS_HPP_
+#define HOMOGMATRIXCONTAINERS_HPP_
+
+#include "AlignedPool.hpp"
+#include "HomogMatrix.hpp"
+
+namespace Types {
+
+/// Containers of homogenous matrices - aligned, with blocks recycled by the AlignedPool.
+typedef AlignedContainers<HomogMatrix>::vector HomogMatrixVector;
+typedef AlignedContainers<HomogMatrix>::deque HomogMatrixDeque;
+typedef AlignedContainers<HomogMatrix>::list HomogMatrixList;
+
+} //: namespace Types
+
+#endif /* HOMOGMATRIXCONTAINERS_HPP_ */
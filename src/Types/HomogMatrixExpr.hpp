@@ -0,0 +1,169 @@
+/*!
+ * \file HomogMatrixExpr.hpp
+ * \brief Lazy (expression template) composition of chains of homogenous matrices.
+ */
+
+#ifndef HOMOGMATRIXEXPR_HPP_
+#define HOMOGMATRIXEXPR_HPP_
+
+#include <vector>
+
+#include "HomogMatrix.hpp"
+
+namespace Types {
+
+/// Compact 3x4 [R|t] form of a rigid transform - the bottom row of a HomogMatrix is always (0 0 0 1).
+/// Rows are stored contiguously, so that every row of the chain product is updated with whole-row (SIMD) operations.
+typedef Eigen::Matrix<double, 3, 4, Eigen::RowMajor> HomogMatrixCompact;
+
+
+/*!
+ * \struct HomogMatrixExpr
+ * \brief Base of the lazy composition expressions.
+ *
+ * Expressions are built with Types::chain(a) * b * c * ... and nothing is computed until the expression
+ * is assigned to a HomogMatrix or applied to points. The whole chain is then folded (at compile time) into
+ * a single pass of 3x3 rotation and translation updates, without 4x4 temporaries.
+ *
+ * Expressions hold references to their operands, so they must not outlive them (as in Eigen).
+ */
+template <typename Derived>
+struct HomogMatrixExpr
+{
+	/// Returns the actual expression type.
+	const Derived & derived() const {
+		return static_cast<const Derived &>(*this);
+	}
+
+	/// Evaluates the whole chain into a compact [R|t] matrix.
+	HomogMatrixCompact eval() const {
+		HomogMatrixCompact out;
+		derived().evalTo(out);
+		return out;
+	}
+
+	/// Transforms a batch of points stored as columns of a 3xN matrix. Output is resized to match input.
+	void transformPoints(const Eigen::Matrix3Xd & in_, Eigen::Matrix3Xd & out_) const {
+		out_.resize(3, in_.cols());
+		transformPointsImpl(in_.data(), out_.data(), in_.cols());
+	}
+
+	/// Transforms a batch of OpenCV points (with doubles).
+	void transformPoints(const std::vector<cv::Point3d> & in_, std::vector<cv::Point3d> & out_) const {
+		out_.resize(in_.size());
+		if (!in_.empty())
+			transformPointsImpl(&in_[0].x, &out_[0].x, in_.size());
+	}
+
+	/// Transforms a batch of OpenCV points (with floats). Computations are done in doubles.
+	void transformPoints(const std::vector<cv::Point3f> & in_, std::vector<cv::Point3f> & out_) const {
+		out_.resize(in_.size());
+		if (!in_.empty())
+			transformPointsImpl(&in_[0].x, &out_[0].x, in_.size());
+	}
+
+private:
+	/// Transforms n points stored as packed xyz triplets. The chain is evaluated once, before the loop.
+	template <typename Scalar>
+	void transformPointsImpl(const Scalar * in_, Scalar * out_, size_t n_) const {
+		const HomogMatrixCompact m = eval();
+		const double m00 = m(0,0), m01 = m(0,1), m02 = m(0,2), m03 = m(0,3);
+		const double m10 = m(1,0), m11 = m(1,1), m12 = m(1,2), m13 = m(1,3);
+		const double m20 = m(2,0), m21 = m(2,1), m22 = m(2,2), m23 = m(2,3);
+		for (size_t i = 0; i < n_; ++i, in_ += 3, out_ += 3) {
+			const double x = in_[0], y = in_[1], z = in_[2];
+			out_[0] = m00 * x + m01 * y + m02 * z + m03;
+			out_[1] = m10 * x + m11 * y + m12 * z + m13;
+			out_[2] = m20 * x + m21 * y + m22 * z + m23;
+		}
+	}
+};
+
+
+/*!
+ * \struct HomogMatrixLeaf
+ * \brief Single (referenced) transform in the chain.
+ */
+struct HomogMatrixLeaf : public HomogMatrixExpr<HomogMatrixLeaf>
+{
+	explicit HomogMatrixLeaf(const HomogMatrixBaseType & hm_) : hm(hm_)
+	{
+	}
+
+	/// Overwrites the accumulator with the transform.
+	void evalTo(HomogMatrixCompact & acc_) const {
+		acc_ = hm.matrix().topRows<3>();
+	}
+
+	/// Right-multiplies the accumulator by the transform: acc = acc * hm.
+	void applyRight(HomogMatrixCompact & acc_) const {
+		// [R_acc|t_acc] * [R|t; 0 1] = [R_acc*R | R_acc*t + t_acc] - each row of the result depends only on the same row of acc.
+		const Eigen::Matrix4d & h = hm.matrix();
+		for (int r = 0; r < 3; ++r) {
+			const double a0 = acc_(r,0), a1 = acc_(r,1), a2 = acc_(r,2);
+			acc_(r,0) = a0 * h(0,0) + a1 * h(1,0) + a2 * h(2,0);
+			acc_(r,1) = a0 * h(0,1) + a1 * h(1,1) + a2 * h(2,1);
+			acc_(r,2) = a0 * h(0,2) + a1 * h(1,2) + a2 * h(2,2);
+			acc_(r,3) += a0 * h(0,3) + a1 * h(1,3) + a2 * h(2,3);
+		}
+	}
+
+	const HomogMatrixBaseType & hm;
+};
+
+
+/*!
+ * \struct HomogMatrixProduct
+ * \brief Lazy product of two expressions.
+ */
+template <typename Lhs, typename Rhs>
+struct HomogMatrixProduct : public HomogMatrixExpr<HomogMatrixProduct<Lhs, Rhs> >
+{
+	HomogMatrixProduct(const Lhs & lhs_, const Rhs & rhs_) : lhs(lhs_), rhs(rhs_)
+	{
+	}
+
+	/// Evaluates the left-most transform and then folds the rest of the chain onto it.
+	void evalTo(HomogMatrixCompact & acc_) const {
+		lhs.evalTo(acc_);
+		rhs.applyRight(acc_);
+	}
+
+	/// Right-multiplies the accumulator by the whole subexpression.
+	void applyRight(HomogMatrixCompact & acc_) const {
+		lhs.applyRight(acc_);
+		rhs.applyRight(acc_);
+	}
+
+	// Subexpressions are tiny (they only hold references), so they are stored by value.
+	const Lhs lhs;
+	const Rhs rhs;
+};
+
+
+/// Starts the lazy chain: Types::chain(a) * b * c.
+inline HomogMatrixLeaf chain(const HomogMatrixBaseType & hm_) {
+	return HomogMatrixLeaf(hm_);
+}
+
+/// Appends a transform to the chain.
+template <typename Lhs>
+inline HomogMatrixProduct<Lhs, HomogMatrixLeaf> operator* (const HomogMatrixExpr<Lhs> & lhs_, const HomogMatrixBaseType & rhs_) {
+	return HomogMatrixProduct<Lhs, HomogMatrixLeaf>(lhs_.derived(), HomogMatrixLeaf(rhs_));
+}
+
+/// Prepends a transform to the chain.
+template <typename Rhs>
+inline HomogMatrixProduct<HomogMatrixLeaf, Rhs> operator* (const HomogMatrixBaseType & lhs_, const HomogMatrixExpr<Rhs> & rhs_) {
+	return HomogMatrixProduct<HomogMatrixLeaf, Rhs>(HomogMatrixLeaf(lhs_), rhs_.derived());
+}
+
+/// Joins two chains.
+template <typename Lhs, typename Rhs>
+inline HomogMatrixProduct<Lhs, Rhs> operator* (const HomogMatrixExpr<Lhs> & lhs_, const HomogMatrixExpr<Rhs> & rhs_) {
+	return HomogMatrixProduct<Lhs, Rhs>(lhs_.derived(), rhs_.derived());
+}
+
+} // namespace Types
+
+#endif /* HOMOGMATRIXEXPR_HPP_ */
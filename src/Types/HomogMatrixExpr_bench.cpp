@@ -0,0 +1,150 @@
+/*!
+ * \file HomogMatrixExpr_bench.cpp
+ * \brief Benchmark of lazy (HomogMatrixExpr) vs eager composition of chains of 2 to 10 homogenous matrices.
+ *
+ * Built when CvCoreTypes_BUILD_BENCHMARKS is enabled.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "HomogMatrixContainers.hpp"
+#include "HomogMatrixExpr.hpp"
+
+using namespace Types;
+
+namespace {
+
+/// Number of evaluations of each chain.
+const int ITERATIONS = 1000000;
+
+/// Number of points transformed by each chain.
+const int POINTS = 1000;
+
+/// Number of chain applications to the point batch.
+const int POINT_ITERATIONS = 2000;
+
+/// Builds chain(hms[0]) * hms[1] * ... * hms[N-1] at compile time and passes it to the functor.
+template <int N>
+struct LazyChain {
+	template <typename Expr, typename Functor>
+	static void apply(const Expr & expr_, const HomogMatrix * hms_, Functor & fun_) {
+		LazyChain<N - 1>::apply(expr_ * (*hms_), hms_ + 1, fun_);
+	}
+};
+
+template <>
+struct LazyChain<0> {
+	template <typename Expr, typename Functor>
+	static void apply(const Expr & expr_, const HomogMatrix *, Functor & fun_) {
+		fun_(expr_);
+	}
+};
+
+/// Assigns the expression to a HomogMatrix.
+struct Evaluate {
+	HomogMatrix result;
+
+	template <typename Expr>
+	void operator()(const Expr & expr_) {
+		result = expr_;
+	}
+};
+
+/// Applies the expression to a batch of points.
+struct Transform {
+	const Eigen::Matrix3Xd & in;
+	Eigen::Matrix3Xd & out;
+
+	Transform(const Eigen::Matrix3Xd & in_, Eigen::Matrix3Xd & out_) : in(in_), out(out_) {}
+
+	template <typename Expr>
+	void operator()(const Expr & expr_) {
+		expr_.transformPoints(in, out);
+	}
+};
+
+double seconds(int64 start_) {
+	return (cv::getTickCount() - start_) / cv::getTickFrequency();
+}
+
+/// Eager composition - every product creates a full 4x4 temporary.
+HomogMatrixBaseType eager(const HomogMatrixVector & hms_, int n_) {
+	HomogMatrixBaseType result = hms_[0];
+	for (int i = 1; i < n_; ++i)
+		result = result * hms_[i];
+	return result;
+}
+
+template <int N>
+void run(HomogMatrixVector & hms_, const Eigen::Matrix3Xd & points_) {
+	// Composition only.
+	double sum = 0;
+	int64 start = cv::getTickCount();
+	for (int i = 0; i < ITERATIONS; ++i) {
+		// Change the input, so the chain cannot be hoisted out of the loop.
+		hms_[0].setFromXYZRPY(1e-3 * i, 0, 0, 1e-6 * i, 0, 0);
+		HomogMatrixBaseType hm = eager(hms_, N);
+		sum += hm(0, 3);
+	}
+	double t_eager = seconds(start);
+
+	Evaluate evaluate;
+	start = cv::getTickCount();
+	for (int i = 0; i < ITERATIONS; ++i) {
+		hms_[0].setFromXYZRPY(1e-3 * i, 0, 0, 1e-6 * i, 0, 0);
+		LazyChain<N - 1>::apply(chain(hms_[0]), &hms_[1], evaluate);
+		sum += evaluate.result(0, 3);
+	}
+	double t_lazy = seconds(start);
+
+	// Composition applied to points.
+	Eigen::Matrix3Xd out(3, points_.cols());
+	start = cv::getTickCount();
+	for (int i = 0; i < POINT_ITERATIONS; ++i) {
+		hms_[0].setFromXYZRPY(1e-3 * i, 0, 0, 1e-6 * i, 0, 0);
+		HomogMatrixBaseType hm = eager(hms_, N);
+		for (int p = 0; p < points_.cols(); ++p)
+			out.col(p) = hm * points_.col(p);
+		sum += out(0, 0);
+	}
+	double t_eager_points = seconds(start);
+
+	Transform transform(points_, out);
+	start = cv::getTickCount();
+	for (int i = 0; i < POINT_ITERATIONS; ++i) {
+		hms_[0].setFromXYZRPY(1e-3 * i, 0, 0, 1e-6 * i, 0, 0);
+		LazyChain<N - 1>::apply(chain(hms_[0]), &hms_[1], transform);
+		sum += out(0, 0);
+	}
+	double t_lazy_points = seconds(start);
+
+	printf("%6d %14.1f %14.1f %16.1f %16.1f   (%g)\n", N,
+			1e9 * t_eager / ITERATIONS, 1e9 * t_lazy / ITERATIONS,
+			1e6 * t_eager_points / POINT_ITERATIONS, 1e6 * t_lazy_points / POINT_ITERATIONS, sum);
+}
+
+}
+
+int main() {
+	HomogMatrixVector hms(10);
+	for (size_t i = 0; i < hms.size(); ++i)
+		hms[i].setFromXYZRPY(0.1 * i, -0.2 * i, 0.3, 0.01 * i, 0.02 * i, -0.03 * i);
+
+	Eigen::Matrix3Xd points = Eigen::Matrix3Xd::Random(3, POINTS);
+
+	printf("%6s %14s %14s %16s %16s\n", "length", "eager [ns]", "lazy [ns]", "eager pts [us]", "lazy pts [us]");
+	run<2>(hms, points);
+	run<3>(hms, points);
+	run<4>(hms, points);
+	run<5>(hms, points);
+	run<6>(hms, points);
+	run<7>(hms, points);
+	run<8>(hms, points);
+	run<9>(hms, points);
+	run<10>(hms, points);
+
+	return 0;
+}
@@ -9,37 +9,115 @@
 #define KEYPOINTS_HPP_
 
 #include "Drawable.hpp"
+#include "DrawablePool.hpp"
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/features2d/features2d.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 namespace Types {
 
+/*!
+ * \class KeyPoints
+ * \brief Drawable set of keypoints.
+ *
+ * Copies duplicate the keypoint vector; use SharedKeyPoints (SharedKeyPoints.hpp) to fan keypoints out
+ * without copying them.
+ */
 class KeyPoints : public Drawable {
 public:
     KeyPoints()
 	{}
 
-    KeyPoints(const Types::KeyPoints & _keypoints) {
-        keypoints.insert(keypoints.end(), _keypoints.keypoints.begin(), _keypoints.keypoints.end());
-	};
+    KeyPoints(const Types::KeyPoints & _keypoints) :
+        Drawable(_keypoints), keypoints(_keypoints.keypoints)
+    {}
+
+    KeyPoints(const std::vector<cv::KeyPoint> & _keypoints) :
+        keypoints(_keypoints)
+    {}
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    KeyPoints(Types::KeyPoints && _keypoints) :
+        Drawable(_keypoints), keypoints(std::move(_keypoints.keypoints))
+    {}
 
-    KeyPoints(const std::vector<cv::KeyPoint> & _keypoints) {
-        keypoints.insert(keypoints.end(), _keypoints.begin(), _keypoints.end());
-	};
+    KeyPoints(std::vector<cv::KeyPoint> && _keypoints) :
+        keypoints(std::move(_keypoints))
+    {}
+
+    KeyPoints & operator=(Types::KeyPoints && _keypoints) {
+        Drawable::operator=(_keypoints);
+        keypoints = std::move(_keypoints.keypoints);
+        return *this;
+    }
+#endif
+
+    KeyPoints & operator=(const Types::KeyPoints & _keypoints) {
+        Drawable::operator=(_keypoints);
+        keypoints = _keypoints.keypoints;
+        return *this;
+    }
 
     virtual ~KeyPoints() {}
 
+	/// Draws keypoints as circles in place, without copying the image.
 	virtual void draw(cv::Mat & image, cv::Scalar color, int offsetX = 0, int offsetY = 0) {
-        cv::drawKeypoints(image, keypoints, image);
+        draw(keypoints, image, color, offsetX, offsetY);
+	}
+
+	virtual cv::Rect bounds(int offsetX = 0, int offsetY = 0) const {
+        return bounds(keypoints, offsetX, offsetY);
+	}
+
+	/// Draws given keypoints as circles.
+	static void draw(const std::vector<cv::KeyPoint> & kps, cv::Mat & image, cv::Scalar color, int offsetX, int offsetY) {
+        for (size_t i = 0; i < kps.size(); ++i) {
+            cv::Point center(cvRound(kps[i].pt.x) + offsetX, cvRound(kps[i].pt.y) + offsetY);
+            cv::circle(image, center, RADIUS, color);
+        }
+	}
+
+	/// Returns the rectangle touched by draw() of given keypoints.
+	static cv::Rect bounds(const std::vector<cv::KeyPoint> & kps, int offsetX, int offsetY) {
+        if (kps.empty())
+            return cv::Rect();
+        float min_x = kps[0].pt.x, max_x = kps[0].pt.x, min_y = kps[0].pt.y, max_y = kps[0].pt.y;
+        for (size_t i = 1; i < kps.size(); ++i) {
+            min_x = std::min(min_x, kps[i].pt.x);
+            max_x = std::max(max_x, kps[i].pt.x);
+            min_y = std::min(min_y, kps[i].pt.y);
+            max_y = std::max(max_y, kps[i].pt.y);
+        }
+        // Circle radius plus a pixel of line width.
+        const int m = RADIUS + 1;
+        int x0 = (int)std::floor(min_x) + offsetX - m, y0 = (int)std::floor(min_y) + offsetY - m;
+        int x1 = (int)std::ceil(max_x) + offsetX + m, y1 = (int)std::ceil(max_y) + offsetY + m;
+        return cv::Rect(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
 	}
 
 	virtual Drawable * clone() {
         return new KeyPoints(*this);
 	}
 
+	virtual boost::shared_ptr<Drawable> cloneHandle() {
+        return DrawablePool<KeyPoints>::cloneHandle(*this);
+	}
+
+	virtual void recycle() {
+        // Keeps the capacity of the buffer.
+        keypoints.clear();
+	}
+
 //private:
     std::vector<cv::KeyPoint> keypoints;
+
+    /// Radius of the drawn circles.
+    static const int RADIUS = 3;
 };
 
 } //: namespace Types
@@ -0,0 +1,108 @@
+/*!
+ * \file KeyPointsDescriptors.hpp
+ * \brief Drawable set of keypoints together with their descriptors.
+ */
+
+#ifndef KEYPOINTSDESCRIPTORS_HPP_
+#define KEYPOINTSDESCRIPTORS_HPP_
+
+#include <boost/shared_ptr.hpp>
+
+#include <opencv2/core/core.hpp>
+
+#include "KeyPoints.hpp"
+#include "DescriptorArena.hpp"
+
+namespace Types {
+
+/*!
+ * \class KeyPointsDescriptors
+ * \brief Keypoints with descriptors stored in a pooled, aligned arena (row i describes keypoint i).
+ *
+ * Descriptors are shared between copies until one of them is modified (keypoints are copied). A producer that
+ * keeps its instance and refills it every frame reuses the arena block as long as no consumer still holds
+ * the previous frame; otherwise a block is taken from the pool.
+ */
+class KeyPointsDescriptors : public KeyPoints {
+public:
+	KeyPointsDescriptors() :
+		arena(new DescriptorArena)
+	{
+	}
+
+	/// Copies keypoints of the given set, descriptors are empty.
+	explicit KeyPointsDescriptors(const KeyPoints & keypoints_) :
+		KeyPoints(keypoints_), arena(new DescriptorArena)
+	{
+	}
+
+	KeyPointsDescriptors(const std::vector<cv::KeyPoint> & keypoints_, const cv::Mat & descriptors_) :
+		KeyPoints(keypoints_), arena(new DescriptorArena)
+	{
+		arena->assign(descriptors_);
+	}
+
+	KeyPointsDescriptors(const KeyPointsDescriptors & other_) :
+		KeyPoints(other_), arena(other_.arena)
+	{
+	}
+
+	KeyPointsDescriptors & operator=(const KeyPointsDescriptors & other_) {
+		KeyPoints::operator=(other_);
+		arena = other_.arena;
+		return *this;
+	}
+
+	virtual ~KeyPointsDescriptors() {}
+
+	virtual Drawable * clone() {
+		return new KeyPointsDescriptors(*this);
+	}
+
+	virtual boost::shared_ptr<Drawable> cloneHandle() {
+		return DrawablePool<KeyPointsDescriptors>::cloneHandle(*this);
+	}
+
+	virtual void recycle() {
+		KeyPoints::recycle();
+		// Gives the descriptors back without allocating a new arena.
+		arena = emptyArena();
+	}
+
+	/// Read-only access to descriptors.
+	const DescriptorArena & descriptors() const {
+		return *arena;
+	}
+
+	/// Write access to descriptors - detaches the arena if it is shared.
+	DescriptorArena & mutableDescriptors() {
+		if (!arena.unique())
+			arena.reset(new DescriptorArena(*arena));
+		return *arena;
+	}
+
+	/// Replaces descriptors with a copy of the matrix.
+	void setDescriptors(const cv::Mat & descriptors_) {
+		if (!arena.unique())
+			arena.reset(new DescriptorArena);
+		arena->assign(descriptors_);
+	}
+
+	/// Returns header of the descriptor matrix (no copy).
+	cv::Mat descriptorsMat() const {
+		return arena->mat();
+	}
+
+private:
+	/// Shared empty arena - never modified, as it is always shared.
+	static const boost::shared_ptr<DescriptorArena> & emptyArena() {
+		static const boost::shared_ptr<DescriptorArena> empty(new DescriptorArena);
+		return empty;
+	}
+
+	boost::shared_ptr<DescriptorArena> arena;
+};
+
+} //: namespace Types
+
+#endif /* KEYPOINTSDESCRIPTORS_HPP_ */
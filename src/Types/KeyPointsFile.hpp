@@ -0,0 +1,413 @@
+/*!
+ * \file KeyPointsFile.hpp
+ * \brief Binary format of recorded keypoint streams - frames of keypoints with optional descriptors and a frame index.
+ *
+ * Layout (native byte order): 32-byte KeyPointsFileHeader, frames, frame index. Every frame consists of
+ * a 24-byte KeyPointsFrameHeader, keypoints stored exactly as cv::KeyPoint (28 bytes each) and packed descriptor rows.
+ * Both blocks are padded to 8 bytes. The index (one uint64_t file offset per frame) is written on close;
+ * files that were not closed properly are indexed by scanning the frames.
+ */
+
+#ifndef KEYPOINTSFILE_HPP_
+#define KEYPOINTSFILE_HPP_
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <opencv2/core/core.hpp>
+
+namespace Types {
+
+/// Header of the keypoints file.
+struct KeyPointsFileHeader {
+	/// Magic string identifying the format.
+	char magic[8];
+
+	/// Format version.
+	uint32_t version;
+
+	/// Unused, keeps the header aligned.
+	uint32_t reserved;
+
+	/// Number of frames - 0 if the file was not closed properly.
+	uint64_t frames;
+
+	/// Offset of the frame index - 0 if the file was not closed properly.
+	uint64_t index_offset;
+};
+
+BOOST_STATIC_ASSERT(sizeof(KeyPointsFileHeader) == 32);
+
+/// Header of a single frame.
+struct KeyPointsFrameHeader {
+	/// Number of keypoints.
+	uint32_t count;
+
+	/// Type of descriptors (CV_8U or CV_32F), -1 if the frame has no descriptors.
+	int32_t descriptor_type;
+
+	/// Length of a descriptor (in elements).
+	uint32_t descriptor_cols;
+
+	/// Unused, keeps the header aligned.
+	uint32_t reserved;
+
+	/// Timestamp of the frame (seconds).
+	double timestamp;
+};
+
+BOOST_STATIC_ASSERT(sizeof(KeyPointsFrameHeader) == 24);
+
+// Keypoints are stored in the in-memory layout of cv::KeyPoint, so they can be read directly from the mapping.
+BOOST_STATIC_ASSERT(sizeof(cv::KeyPoint) == 7 * 4);
+
+/// Magic string of the keypoints file.
+static const char KEYPOINTS_FILE_MAGIC[8] = { 'D', 'C', 'L', 'K', 'P', 'T', 'S', '\0' };
+
+/// Current version of the format.
+static const uint32_t KEYPOINTS_FILE_VERSION = 1;
+
+
+/*!
+ * \class KeyPointsFrame
+ * \brief View of a single frame stored in a KeyPointsFileReader mapping (valid as long as the reader is open).
+ */
+class KeyPointsFrame {
+public:
+	/// Rounds the size up to the frame padding.
+	static size_t pad(size_t bytes_) {
+		return (bytes_ + 7) & ~(size_t) 7;
+	}
+
+	/// Size of the descriptor row in bytes.
+	static size_t descriptorBytes(const KeyPointsFrameHeader & header_) {
+		if (header_.descriptor_type < 0)
+			return 0;
+		return header_.descriptor_cols * (header_.descriptor_type == CV_32F ? sizeof(float) : sizeof(uchar));
+	}
+
+	/// Size of the whole frame in bytes.
+	static size_t frameSize(const KeyPointsFrameHeader & header_) {
+		return sizeof(KeyPointsFrameHeader) + pad(header_.count * sizeof(cv::KeyPoint))
+				+ pad(header_.count * descriptorBytes(header_));
+	}
+
+	/*!
+	 * Appends serialized frame to the buffer.
+	 * \param descriptors_ descriptors (CV_8U or CV_32F, one row per keypoint) or empty matrix
+	 */
+	static void serialize(const std::vector<cv::KeyPoint> & keypoints_, const cv::Mat & descriptors_, double timestamp_,
+			std::vector<char> & out_) {
+		KeyPointsFrameHeader header;
+		std::memset(&header, 0, sizeof(header));
+		header.count = keypoints_.size();
+		header.descriptor_type = -1;
+		header.timestamp = timestamp_;
+		if (!descriptors_.empty()) {
+			CV_Assert(descriptors_.type() == CV_8U || descriptors_.type() == CV_32F);
+			CV_Assert(descriptors_.rows == (int) keypoints_.size());
+			header.descriptor_type = descriptors_.type();
+			header.descriptor_cols = descriptors_.cols;
+		}
+
+		const size_t begin = out_.size();
+		out_.resize(begin + frameSize(header), 0);
+		char * p = &out_[begin];
+		std::memcpy(p, &header, sizeof(header));
+		p += sizeof(header);
+		if (!keypoints_.empty())
+			std::memcpy(p, &keypoints_[0], keypoints_.size() * sizeof(cv::KeyPoint));
+		p += pad(keypoints_.size() * sizeof(cv::KeyPoint));
+		const size_t row = descriptorBytes(header);
+		for (int i = 0; i < descriptors_.rows && row > 0; ++i, p += row)
+			std::memcpy(p, descriptors_.ptr(i), row);
+	}
+
+	explicit KeyPointsFrame(const char * data_) :
+		header(reinterpret_cast<const KeyPointsFrameHeader *>(data_))
+	{
+	}
+
+	/// Number of keypoints.
+	size_t size() const {
+		return header->count;
+	}
+
+	double timestamp() const {
+		return header->timestamp;
+	}
+
+	/// Keypoints, read directly from the mapping.
+	const cv::KeyPoint * begin() const {
+		return reinterpret_cast<const cv::KeyPoint *>(reinterpret_cast<const char *>(header) + sizeof(KeyPointsFrameHeader));
+	}
+
+	const cv::KeyPoint * end() const {
+		return begin() + header->count;
+	}
+
+	bool hasDescriptors() const {
+		return header->descriptor_type >= 0;
+	}
+
+	/// Returns header of the descriptor matrix pointing into the mapping (no copy), empty if there are no descriptors.
+	cv::Mat descriptors() const {
+		if (!hasDescriptors() || header->count == 0)
+			return cv::Mat();
+		const char * d = reinterpret_cast<const char *>(begin()) + pad(header->count * sizeof(cv::KeyPoint));
+		return cv::Mat(header->count, header->descriptor_cols, header->descriptor_type, const_cast<char *>(d));
+	}
+
+private:
+	const KeyPointsFrameHeader * header;
+};
+
+
+/*!
+ * \class KeyPointsFileReader
+ * \brief Memory-mapped, read-only view of the keypoints file - O(1) access to frames through the index.
+ */
+class KeyPointsFileReader : private boost::noncopyable {
+public:
+	KeyPointsFileReader() :
+		base(NULL), index(NULL), count(0)
+	{
+	}
+
+	/// Checks whether the file starts with the keypoints file magic string.
+	static bool isKeyPointsFile(const std::string & filename_) {
+		char magic[sizeof(KEYPOINTS_FILE_MAGIC)];
+		std::FILE * f = std::fopen(filename_.c_str(), "rb");
+		if (!f)
+			return false;
+		bool ret = (std::fread(magic, 1, sizeof(magic), f) == sizeof(magic))
+				&& (std::memcmp(magic, KEYPOINTS_FILE_MAGIC, sizeof(magic)) == 0);
+		std::fclose(f);
+		return ret;
+	}
+
+	/// Maps the file. Throws std::runtime_error if the file is not a valid keypoints file.
+	void open(const std::string & filename_) {
+		close();
+
+		boost::interprocess::file_mapping file(filename_.c_str(), boost::interprocess::read_only);
+		boost::interprocess::mapped_region region(file, boost::interprocess::read_only);
+
+		const size_t size = region.get_size();
+		if (size < sizeof(KeyPointsFileHeader))
+			throw std::runtime_error("Keypoints file too short: " + filename_);
+
+		const char * data = static_cast<const char *>(region.get_address());
+		const KeyPointsFileHeader * header = reinterpret_cast<const KeyPointsFileHeader *>(data);
+		if (std::memcmp(header->magic, KEYPOINTS_FILE_MAGIC, sizeof(KEYPOINTS_FILE_MAGIC)) != 0)
+			throw std::runtime_error("Not a keypoints file: " + filename_);
+		if (header->version != KEYPOINTS_FILE_VERSION)
+			throw std::runtime_error("Unsupported keypoints file version: " + filename_);
+
+		const bool indexed = header->index_offset != 0 && header->index_offset <= size
+				&& header->frames <= (size - header->index_offset) / sizeof(uint64_t);
+		if (indexed) {
+			const uint64_t * idx = reinterpret_cast<const uint64_t *>(data + header->index_offset);
+			for (size_t i = 0; i < header->frames; ++i)
+				if (!validFrame(data, header->index_offset, idx[i]))
+					throw std::runtime_error("Corrupted frame index in keypoints file: " + filename_);
+		} else {
+			// No index - the file was not closed properly, take all complete frames.
+			for (uint64_t offset = sizeof(KeyPointsFileHeader); validFrame(data, size, offset);
+					offset += KeyPointsFrame::frameSize(*reinterpret_cast<const KeyPointsFrameHeader *>(data + offset)))
+				scanned.push_back(offset);
+		}
+
+		count = indexed ? header->frames : scanned.size();
+		const uint64_t index_offset = header->index_offset;
+		region.swap(mapping);
+		base = static_cast<const char *>(mapping.get_address());
+		if (indexed)
+			index = reinterpret_cast<const uint64_t *>(base + index_offset);
+		else if (!scanned.empty())
+			index = &scanned[0];
+	}
+
+	/// Unmaps the file.
+	void close() {
+		boost::interprocess::mapped_region empty;
+		mapping.swap(empty);
+		scanned.clear();
+		base = NULL;
+		index = NULL;
+		count = 0;
+	}
+
+	/// Returns true if the file is mapped.
+	bool isOpen() const {
+		return base != NULL;
+	}
+
+	/// Number of frames.
+	size_t size() const {
+		return count;
+	}
+
+	/// Returns view of the frame with given index.
+	KeyPointsFrame frame(size_t index_) const {
+		return KeyPointsFrame(base + index[index_]);
+	}
+
+	/// Asks the OS to read ahead frames [begin, begin + n) - returns immediately, pages are loaded in the background.
+	void prefetch(size_t begin_, size_t n_) const {
+		if (!base || begin_ >= count)
+			return;
+		if (n_ > count - begin_)
+			n_ = count - begin_;
+		const size_t last = begin_ + n_ - 1;
+		const uintptr_t page = boost::interprocess::mapped_region::get_page_size();
+		uintptr_t from = reinterpret_cast<uintptr_t>(base + index[begin_]) & ~(page - 1);
+		uintptr_t to = reinterpret_cast<uintptr_t>(base + index[last])
+				+ KeyPointsFrame::frameSize(*reinterpret_cast<const KeyPointsFrameHeader *>(base + index[last]));
+		::posix_madvise(reinterpret_cast<void *>(from), to - from, POSIX_MADV_WILLNEED);
+	}
+
+private:
+	/// Checks whether a complete frame starts at the offset and ends before the limit.
+	static bool validFrame(const char * data_, uint64_t limit_, uint64_t offset_) {
+		if (offset_ < sizeof(KeyPointsFileHeader) || offset_ % 8 != 0 || offset_ + sizeof(KeyPointsFrameHeader) > limit_)
+			return false;
+		const KeyPointsFrameHeader * h = reinterpret_cast<const KeyPointsFrameHeader *>(data_ + offset_);
+		if (h->descriptor_type != -1 && h->descriptor_type != CV_8U && h->descriptor_type != CV_32F)
+			return false;
+		return KeyPointsFrame::frameSize(*h) <= limit_ - offset_;
+	}
+
+	/// Mapped file.
+	boost::interprocess::mapped_region mapping;
+
+	/// Beginning of the mapping.
+	const char * base;
+
+	/// Offsets of frames - in the mapping or in the scanned vector.
+	const uint64_t * index;
+
+	/// Offsets of frames found by scanning a file without index.
+	std::vector<uint64_t> scanned;
+
+	/// Number of frames.
+	size_t count;
+};
+
+
+/*!
+ * \class KeyPointsFileWriter
+ * \brief Append-only writer of the keypoints file.
+ *
+ * Offsets of appended frames are collected in memory and written as the frame index on close().
+ */
+class KeyPointsFileWriter : private boost::noncopyable {
+public:
+	KeyPointsFileWriter() :
+		file(NULL), offset(0)
+	{
+	}
+
+	~KeyPointsFileWriter() {
+		close();
+	}
+
+	/// Creates (truncates) the file and writes the header. Throws std::runtime_error on failure.
+	void open(const std::string & filename_) {
+		close();
+
+		file = std::fopen(filename_.c_str(), "wb");
+		if (!file)
+			throw std::runtime_error("Could not create keypoints file: " + filename_);
+
+		index.clear();
+		if (!writeHeader(0))
+			throw std::runtime_error("Could not write keypoints file header: " + filename_);
+		offset = sizeof(KeyPointsFileHeader);
+	}
+
+	/// Appends a single frame.
+	void append(const std::vector<cv::KeyPoint> & keypoints_, const cv::Mat & descriptors_, double timestamp_) {
+		buffer.clear();
+		KeyPointsFrame::serialize(keypoints_, descriptors_, timestamp_, buffer);
+		appendFrames(&buffer[0], buffer.size());
+	}
+
+	/// Appends a block of frames serialized with KeyPointsFrame::serialize().
+	void appendFrames(const char * data_, size_t bytes_) {
+		for (size_t pos = 0; pos < bytes_; ) {
+			index.push_back(offset + pos);
+			pos += KeyPointsFrame::frameSize(*reinterpret_cast<const KeyPointsFrameHeader *>(data_ + pos));
+		}
+		if (std::fwrite(data_, 1, bytes_, file) != bytes_)
+			throw std::runtime_error("Could not write to keypoints file");
+		offset += bytes_;
+	}
+
+	/// Flushes the buffered frames to the file.
+	void flush() {
+		if (file)
+			std::fflush(file);
+	}
+
+	/// Writes the frame index, updates the header and closes the file.
+	void close() {
+		if (!file)
+			return;
+		const uint64_t index_offset = offset;
+		bool ok = index.empty() || std::fwrite(&index[0], sizeof(uint64_t), index.size(), file) == index.size();
+		std::fseek(file, 0, SEEK_SET);
+		// Without a complete index the reader scans the frames.
+		writeHeader(ok ? index_offset : 0);
+		std::fclose(file);
+		file = NULL;
+	}
+
+	/// Returns true if the file is open.
+	bool isOpen() const {
+		return file != NULL;
+	}
+
+	/// Number of frames written so far.
+	size_t size() const {
+		return index.size();
+	}
+
+private:
+	bool writeHeader(uint64_t index_offset_) {
+		KeyPointsFileHeader header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, KEYPOINTS_FILE_MAGIC, sizeof(KEYPOINTS_FILE_MAGIC));
+		header.version = KEYPOINTS_FILE_VERSION;
+		header.frames = index_offset_ ? index.size() : 0;
+		header.index_offset = index_offset_;
+		return std::fwrite(&header, sizeof(header), 1, file) == 1;
+	}
+
+	/// Output file.
+	std::FILE * file;
+
+	/// Current size of the file.
+	uint64_t offset;
+
+	/// Offsets of written frames.
+	std::vector<uint64_t> index;
+
+	/// Buffer of a single serialized frame.
+	std::vector<char> buffer;
+};
+
+} // namespace Types
+
+#endif /* KEYPOINTSFILE_HPP_ */
@@ -0,0 +1,353 @@
+/*!
+ * \file KeyPointsGrid.hpp
+ * \brief Uniform grid index of keypoints - radius and k-NN queries, adaptive non-maximal suppression and
+ * per-cell top-K selection.
+ */
+
+#ifndef KEYPOINTSGRID_HPP_
+#define KEYPOINTSGRID_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "KeyPoints.hpp"
+
+namespace Types {
+
+/*!
+ * \class KeyPointsGrid
+ * \brief Uniform grid hash of keypoint positions.
+ *
+ * The grid is built in O(N) with a counting sort of keypoints into cells. Positions are stored in cell order,
+ * so queries scan contiguous memory. All returned indices refer to the vector passed to build().
+ */
+class KeyPointsGrid {
+public:
+	KeyPointsGrid() :
+		origin_x(0), origin_y(0), cell_w(1), cell_h(1), inv_cell_w(1), inv_cell_h(1), cols(0), rows(0)
+	{
+	}
+
+	/// Builds the grid of square cells covering all keypoints.
+	void build(const std::vector<cv::KeyPoint> & keypoints_, float cell_size_) {
+		CV_Assert(cell_size_ > 0);
+		float min_x = 0, min_y = 0, max_x = 0, max_y = 0;
+		if (!keypoints_.empty()) {
+			min_x = max_x = keypoints_[0].pt.x;
+			min_y = max_y = keypoints_[0].pt.y;
+		}
+		for (size_t i = 1; i < keypoints_.size(); ++i) {
+			min_x = std::min(min_x, keypoints_[i].pt.x);
+			max_x = std::max(max_x, keypoints_[i].pt.x);
+			min_y = std::min(min_y, keypoints_[i].pt.y);
+			max_y = std::max(max_y, keypoints_[i].pt.y);
+		}
+		int c = (int)((max_x - min_x) / cell_size_) + 1;
+		int r = (int)((max_y - min_y) / cell_size_) + 1;
+		buildImpl(keypoints_, min_x, min_y, cell_size_, cell_size_, c, r);
+	}
+
+	/// Builds the grid of cols x rows cells covering the area (keypoints outside are clamped to border cells).
+	void build(const std::vector<cv::KeyPoint> & keypoints_, const cv::Rect & area_, int cols_, int rows_) {
+		CV_Assert(cols_ > 0 && rows_ > 0 && area_.width > 0 && area_.height > 0);
+		buildImpl(keypoints_, area_.x, area_.y, (float)area_.width / cols_, (float)area_.height / rows_, cols_, rows_);
+	}
+
+	/// Returns indices of keypoints lying within the radius from the center.
+	void radiusSearch(const cv::Point2f & center_, float radius_, std::vector<int> & indices_) const {
+		indices_.clear();
+		if (xs.empty())
+			return;
+		const float r2 = radius_ * radius_;
+		int c0, r0, c1, r1;
+		cellOf(center_.x - radius_, center_.y - radius_, c0, r0);
+		cellOf(center_.x + radius_, center_.y + radius_, c1, r1);
+		for (int r = r0; r <= r1; ++r) {
+			for (int c = c0; c <= c1; ++c) {
+				const int cell = r * cols + c;
+				for (int i = cell_start[cell]; i < cell_start[cell + 1]; ++i) {
+					const float dx = xs[i] - center_.x, dy = ys[i] - center_.y;
+					if (dx * dx + dy * dy <= r2)
+						indices_.push_back(order[i]);
+				}
+			}
+		}
+	}
+
+	/// Returns indices of (up to) k keypoints nearest to the center, sorted by distance.
+	void knnSearch(const cv::Point2f & center_, size_t k_, std::vector<int> & indices_) const {
+		indices_.clear();
+		if (xs.empty() || k_ == 0)
+			return;
+
+		// Max-heap of the k best (squared distance, position in cell order). It is local, so concurrent
+		// queries on the same grid are safe.
+		std::vector<std::pair<float, int> > best;
+		best.reserve(std::min(k_, xs.size()));
+
+		int cc, cr;
+		cellOf(center_.x, center_.y, cc, cr);
+		const int max_ring = std::max(std::max(cc, cols - 1 - cc), std::max(cr, rows - 1 - cr));
+		for (int ring = 0; ring <= max_ring; ++ring) {
+			// Points in this ring are at least (ring - 1) cells away from the center.
+			if (best.size() == k_) {
+				float bound = (ring - 1) * std::min(cell_w, cell_h);
+				if (bound > 0 && bound * bound > best.front().first)
+					break;
+			}
+			for (int r = cr - ring; r <= cr + ring; ++r) {
+				if (r < 0 || r >= rows)
+					continue;
+				// Whole rows at the top and bottom of the ring, only the two border cells otherwise.
+				const bool full = (r == cr - ring) || (r == cr + ring);
+				const int step = full ? 1 : std::max(1, 2 * ring);
+				for (int c = cc - ring; c <= cc + ring; c += step) {
+					if (c < 0 || c >= cols)
+						continue;
+					const int cell = r * cols + c;
+					for (int i = cell_start[cell]; i < cell_start[cell + 1]; ++i) {
+						const float dx = xs[i] - center_.x, dy = ys[i] - center_.y;
+						const float d2 = dx * dx + dy * dy;
+						if (best.size() < k_) {
+							best.push_back(std::make_pair(d2, i));
+							std::push_heap(best.begin(), best.end());
+						} else if (d2 < best.front().first) {
+							std::pop_heap(best.begin(), best.end());
+							best.back() = std::make_pair(d2, i);
+							std::push_heap(best.begin(), best.end());
+						}
+					}
+				}
+			}
+		}
+
+		std::sort_heap(best.begin(), best.end());
+		indices_.resize(best.size());
+		for (size_t i = 0; i < best.size(); ++i)
+			indices_[i] = order[best[i].second];
+	}
+
+	/// Number of cells in a row.
+	int gridCols() const {
+		return cols;
+	}
+
+	/// Number of cell rows.
+	int gridRows() const {
+		return rows;
+	}
+
+	/// Returns indices of keypoints in the given cell.
+	void cell(int col_, int row_, std::vector<int> & indices_) const {
+		const int cell = row_ * cols + col_;
+		indices_.assign(order.begin() + cell_start[cell], order.begin() + cell_start[cell + 1]);
+	}
+
+
+	/*!
+	 * Adaptive non-maximal suppression - selects up to n keypoints with the largest suppression radius,
+	 * i.e. distance to the nearest keypoint with sufficiently higher response (response_i < robustness * response_j).
+	 * Keypoints are returned in the order of decreasing radius. If cell size is not given, it is chosen
+	 * so that there are about two keypoints per cell.
+	 */
+	static void anms(const std::vector<cv::KeyPoint> & keypoints_, size_t n_, std::vector<int> & selected_,
+			float robustness_ = 0.9f, float cell_size_ = 0) {
+		selected_.clear();
+		const size_t count = keypoints_.size();
+		if (count == 0 || n_ == 0)
+			return;
+		if (n_ > count)
+			n_ = count;
+
+		// Keypoints sorted by decreasing response.
+		std::vector<std::pair<float, int> > by_response(count);
+		for (size_t i = 0; i < count; ++i)
+			by_response[i] = std::make_pair(-keypoints_[i].response, (int)i);
+		std::sort(by_response.begin(), by_response.end());
+
+		// Grid built in the order of decreasing response, so in every cell the already inserted suppressors
+		// always form a prefix - insertion is just incrementing the cell's counter.
+		std::vector<cv::KeyPoint> sorted(count);
+		for (size_t i = 0; i < count; ++i)
+			sorted[i] = keypoints_[by_response[i].second];
+		KeyPointsGrid grid;
+		if (cell_size_ <= 0)
+			cell_size_ = autoCellSize(sorted, 2);
+		grid.build(sorted, cell_size_);
+		std::vector<int> inserted(grid.cell_start.begin(), grid.cell_start.end() - 1);
+
+		std::vector<std::pair<float, int> > radii(count);
+		size_t next = 0;
+		for (size_t i = 0; i < count; ++i) {
+			const float response = sorted[i].response;
+			// Insert all keypoints strong enough to suppress this one.
+			while (next < i && robustness_ * sorted[next].response > response) {
+				++inserted[grid.cellIndex(sorted[next].pt.x, sorted[next].pt.y)];
+				++next;
+			}
+			float r2 = (next == 0) ? std::numeric_limits<float>::max() : grid.nearestInserted(sorted[i].pt, inserted);
+			radii[i] = std::make_pair(-r2, by_response[i].second);
+		}
+
+		// Keep n keypoints with the largest radius.
+		std::nth_element(radii.begin(), radii.begin() + (n_ - 1), radii.end());
+		std::sort(radii.begin(), radii.begin() + n_);
+		selected_.resize(n_);
+		for (size_t i = 0; i < n_; ++i)
+			selected_[i] = radii[i].second;
+	}
+
+	/*!
+	 * Uniform selection - divides the area into cols x rows cells and keeps (up to) k keypoints with the highest
+	 * response in every cell. Indices are returned cell by cell.
+	 */
+	static void gridTopK(const std::vector<cv::KeyPoint> & keypoints_, const cv::Rect & area_, int cols_, int rows_,
+			size_t k_, std::vector<int> & selected_) {
+		selected_.clear();
+		KeyPointsGrid grid;
+		grid.build(keypoints_, area_, cols_, rows_);
+
+		std::vector<std::pair<float, int> > cell;
+		for (int c = 0; c < cols_ * rows_; ++c) {
+			const int begin = grid.cell_start[c], end = grid.cell_start[c + 1];
+			cell.resize(end - begin);
+			for (int i = begin; i < end; ++i)
+				cell[i - begin] = std::make_pair(-keypoints_[grid.order[i]].response, grid.order[i]);
+			const size_t k = std::min(k_, cell.size());
+			if (k < cell.size())
+				std::nth_element(cell.begin(), cell.begin() + k, cell.end());
+			for (size_t i = 0; i < k; ++i)
+				selected_.push_back(cell[i].second);
+		}
+	}
+
+	/// Returns keypoints with given indices.
+	static Types::KeyPoints select(const std::vector<cv::KeyPoint> & keypoints_, const std::vector<int> & indices_) {
+		std::vector<cv::KeyPoint> kps(indices_.size());
+		for (size_t i = 0; i < indices_.size(); ++i)
+			kps[i] = keypoints_[indices_[i]];
+		return Types::KeyPoints(kps);
+	}
+
+	/// Returns the size of square cells which gives about the given number of keypoints per cell.
+	static float autoCellSize(const std::vector<cv::KeyPoint> & keypoints_, float per_cell_) {
+		if (keypoints_.empty())
+			return 1;
+		cv::Point2f lo = keypoints_[0].pt, hi = keypoints_[0].pt;
+		for (size_t i = 1; i < keypoints_.size(); ++i) {
+			lo.x = std::min(lo.x, keypoints_[i].pt.x);
+			lo.y = std::min(lo.y, keypoints_[i].pt.y);
+			hi.x = std::max(hi.x, keypoints_[i].pt.x);
+			hi.y = std::max(hi.y, keypoints_[i].pt.y);
+		}
+		const float area = std::max(1.0f, (hi.x - lo.x) * (hi.y - lo.y));
+		return std::max(1.0f, std::sqrt(area * per_cell_ / keypoints_.size()));
+	}
+
+private:
+	void buildImpl(const std::vector<cv::KeyPoint> & keypoints_, float origin_x_, float origin_y_,
+			float cell_w_, float cell_h_, int cols_, int rows_) {
+		origin_x = origin_x_;
+		origin_y = origin_y_;
+		cell_w = cell_w_;
+		cell_h = cell_h_;
+		inv_cell_w = 1.0f / cell_w_;
+		inv_cell_h = 1.0f / cell_h_;
+		cols = cols_;
+		rows = rows_;
+
+		const size_t n = keypoints_.size();
+		const int cells = cols * rows;
+
+		// Counting sort of keypoints into cells.
+		std::vector<int> & cell_of = scratch;
+		cell_of.resize(n);
+		cell_start.assign(cells + 1, 0);
+		for (size_t i = 0; i < n; ++i) {
+			cell_of[i] = cellIndex(keypoints_[i].pt.x, keypoints_[i].pt.y);
+			++cell_start[cell_of[i] + 1];
+		}
+		for (int c = 0; c < cells; ++c)
+			cell_start[c + 1] += cell_start[c];
+
+		std::vector<int> pos(cell_start.begin(), cell_start.end() - 1);
+		order.resize(n);
+		xs.resize(n);
+		ys.resize(n);
+		for (size_t i = 0; i < n; ++i) {
+			const int p = pos[cell_of[i]]++;
+			order[p] = (int)i;
+			xs[p] = keypoints_[i].pt.x;
+			ys[p] = keypoints_[i].pt.y;
+		}
+	}
+
+	/// Computes cell coordinates (clamped to the grid).
+	void cellOf(float x_, float y_, int & col_, int & row_) const {
+		col_ = std::min(cols - 1, std::max(0, (int)std::floor((x_ - origin_x) * inv_cell_w)));
+		row_ = std::min(rows - 1, std::max(0, (int)std::floor((y_ - origin_y) * inv_cell_h)));
+	}
+
+	int cellIndex(float x_, float y_) const {
+		int c, r;
+		cellOf(x_, y_, c, r);
+		return r * cols + c;
+	}
+
+	/// Squared distance to the nearest point among the first inserted[cell] points of every cell.
+	float nearestInserted(const cv::Point2f & p_, const std::vector<int> & inserted_) const {
+		float best = std::numeric_limits<float>::max();
+		int cc, cr;
+		cellOf(p_.x, p_.y, cc, cr);
+		const int max_ring = std::max(std::max(cc, cols - 1 - cc), std::max(cr, rows - 1 - cr));
+		for (int ring = 0; ring <= max_ring; ++ring) {
+			float bound = (ring - 1) * std::min(cell_w, cell_h);
+			if (bound > 0 && bound * bound > best)
+				break;
+			for (int r = cr - ring; r <= cr + ring; ++r) {
+				if (r < 0 || r >= rows)
+					continue;
+				const bool full = (r == cr - ring) || (r == cr + ring);
+				const int step = full ? 1 : std::max(1, 2 * ring);
+				for (int c = cc - ring; c <= cc + ring; c += step) {
+					if (c < 0 || c >= cols)
+						continue;
+					const int cell = r * cols + c;
+					for (int i = cell_start[cell]; i < inserted_[cell]; ++i) {
+						const float dx = xs[i] - p_.x, dy = ys[i] - p_.y;
+						best = std::min(best, dx * dx + dy * dy);
+					}
+				}
+			}
+		}
+		return best;
+	}
+
+	/// Grid geometry.
+	float origin_x, origin_y;
+	float cell_w, cell_h;
+	float inv_cell_w, inv_cell_h;
+	int cols, rows;
+
+	/// Position of the first point of every cell in cell order (cols * rows + 1 entries).
+	std::vector<int> cell_start;
+
+	/// Original indices of points in cell order.
+	std::vector<int> order;
+
+	/// Coordinates of points in cell order.
+	std::vector<float> xs, ys;
+
+	/// Reused buffer.
+	std::vector<int> scratch;
+};
+
+} //: namespace Types
+
+#endif /* KEYPOINTSGRID_HPP_ */
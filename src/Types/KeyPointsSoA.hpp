@@ -0,0 +1,275 @@
+/*!
+ * \file KeyPointsSoA.hpp
+ * \brief Structure-of-arrays representation of keypoints, suited for fast filtering and selection.
+ */
+
+#ifndef KEYPOINTSSOA_HPP_
+#define KEYPOINTSSOA_HPP_
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "KeyPoints.hpp"
+
+namespace Types {
+
+/*!
+ * \class KeyPointsSoA
+ * \brief Keypoints stored column-wise (x, y, size, angle, response, octave, class_id).
+ *
+ * Filters walk only the columns they need - e.g. response threshold reads 4 bytes per keypoint instead of
+ * the whole cv::KeyPoint. All loops are branch-free over contiguous arrays, so they are vectorised by the compiler.
+ * Filters keep the original order of keypoints.
+ */
+class KeyPointsSoA {
+public:
+	KeyPointsSoA()
+	{
+	}
+
+	explicit KeyPointsSoA(const std::vector<cv::KeyPoint> & keypoints_) {
+		assign(keypoints_);
+	}
+
+	explicit KeyPointsSoA(const Types::KeyPoints & keypoints_) {
+		assign(keypoints_.keypoints);
+	}
+
+	/// Converts keypoints into columns.
+	void assign(const std::vector<cv::KeyPoint> & keypoints_) {
+		resize(keypoints_.size());
+		for (size_t i = 0; i < keypoints_.size(); ++i) {
+			const cv::KeyPoint & kp = keypoints_[i];
+			x[i] = kp.pt.x;
+			y[i] = kp.pt.y;
+			sizes[i] = kp.size;
+			angles[i] = kp.angle;
+			responses[i] = kp.response;
+			octaves[i] = kp.octave;
+			class_ids[i] = kp.class_id;
+		}
+	}
+
+	/// Converts columns back into keypoints.
+	void toKeyPoints(std::vector<cv::KeyPoint> & keypoints_) const {
+		keypoints_.resize(size());
+		for (size_t i = 0; i < size(); ++i)
+			keypoints_[i] = at(i);
+	}
+
+	/// Converts columns back into keypoints.
+	Types::KeyPoints toKeyPoints() const {
+		std::vector<cv::KeyPoint> kps;
+		toKeyPoints(kps);
+		return Types::KeyPoints(kps);
+	}
+
+	/// Returns keypoint with given index.
+	cv::KeyPoint at(size_t i_) const {
+		return cv::KeyPoint(x[i_], y[i_], sizes[i_], angles[i_], responses[i_], octaves[i_], class_ids[i_]);
+	}
+
+	/// Appends keypoint.
+	void push_back(const cv::KeyPoint & kp_) {
+		x.push_back(kp_.pt.x);
+		y.push_back(kp_.pt.y);
+		sizes.push_back(kp_.size);
+		angles.push_back(kp_.angle);
+		responses.push_back(kp_.response);
+		octaves.push_back(kp_.octave);
+		class_ids.push_back(kp_.class_id);
+	}
+
+	/// Number of keypoints.
+	size_t size() const {
+		return x.size();
+	}
+
+	bool empty() const {
+		return x.empty();
+	}
+
+	void resize(size_t n_) {
+		x.resize(n_);
+		y.resize(n_);
+		sizes.resize(n_);
+		angles.resize(n_);
+		responses.resize(n_);
+		octaves.resize(n_);
+		class_ids.resize(n_);
+	}
+
+	void reserve(size_t n_) {
+		x.reserve(n_);
+		y.reserve(n_);
+		sizes.reserve(n_);
+		angles.reserve(n_);
+		responses.reserve(n_);
+		octaves.reserve(n_);
+		class_ids.reserve(n_);
+	}
+
+	void clear() {
+		resize(0);
+	}
+
+
+	/// Sets mask[i] to 1 for keypoints with response >= threshold, returns number of such keypoints.
+	size_t responseMask(float threshold_, std::vector<uchar> & mask_) const {
+		const size_t n = size();
+		mask_.resize(n);
+		if (n == 0)
+			return 0;
+		const float * r = &responses[0];
+		uchar * m = &mask_[0];
+		for (size_t i = 0; i < n; ++i)
+			m[i] = (r[i] >= threshold_);
+		return countMask(mask_);
+	}
+
+	/// Sets mask[i] to 1 for keypoints from octaves [min, max], returns number of such keypoints.
+	size_t octaveMask(int min_, int max_, std::vector<uchar> & mask_) const {
+		const size_t n = size();
+		mask_.resize(n);
+		if (n == 0)
+			return 0;
+		const int * o = &octaves[0];
+		uchar * m = &mask_[0];
+		for (size_t i = 0; i < n; ++i)
+			m[i] = (o[i] >= min_) & (o[i] <= max_);
+		return countMask(mask_);
+	}
+
+	/// Sets mask[i] to 1 for keypoints lying inside the rectangle, returns number of such keypoints.
+	size_t roiMask(const cv::Rect & roi_, std::vector<uchar> & mask_) const {
+		const size_t n = size();
+		mask_.resize(n);
+		if (n == 0)
+			return 0;
+		const float x0 = roi_.x, y0 = roi_.y, x1 = roi_.x + roi_.width, y1 = roi_.y + roi_.height;
+		const float * px = &x[0];
+		const float * py = &y[0];
+		uchar * m = &mask_[0];
+		for (size_t i = 0; i < n; ++i)
+			m[i] = (px[i] >= x0) & (px[i] < x1) & (py[i] >= y0) & (py[i] < y1);
+		return countMask(mask_);
+	}
+
+	/// Combines two masks: mask &= other.
+	static void andMask(std::vector<uchar> & mask_, const std::vector<uchar> & other_) {
+		CV_Assert(mask_.size() == other_.size());
+		for (size_t i = 0; i < mask_.size(); ++i)
+			mask_[i] &= other_[i];
+	}
+
+	/// Counts selected keypoints.
+	static size_t countMask(const std::vector<uchar> & mask_) {
+		size_t count = 0;
+		for (size_t i = 0; i < mask_.size(); ++i)
+			count += mask_[i];
+		return count;
+	}
+
+	/// Keeps only keypoints selected by the mask (mask values must be 0 or 1).
+	void select(const std::vector<uchar> & mask_) {
+		CV_Assert(mask_.size() == size());
+
+		// Indices of kept keypoints, computed without branches.
+		std::vector<int> & idx = indices;
+		idx.resize(size());
+		size_t n = 0;
+		for (size_t i = 0; i < mask_.size(); ++i) {
+			idx[n] = (int)i;
+			n += mask_[i];
+		}
+		idx.resize(n);
+
+		gather(idx);
+	}
+
+	/// Keeps only keypoints with response >= threshold.
+	void filterByResponse(float threshold_) {
+		std::vector<uchar> mask;
+		responseMask(threshold_, mask);
+		select(mask);
+	}
+
+	/// Keeps only keypoints from octaves [min, max].
+	void filterByOctave(int min_, int max_) {
+		std::vector<uchar> mask;
+		octaveMask(min_, max_, mask);
+		select(mask);
+	}
+
+	/// Keeps k keypoints with the highest response (order of keypoints is preserved).
+	void retainBest(size_t k_) {
+		const size_t n = size();
+		if (k_ >= n)
+			return;
+		if (k_ == 0) {
+			clear();
+			return;
+		}
+
+		// Find the k-th highest response on a copy of the (contiguous) response column.
+		std::vector<float> & r = scratch;
+		r.assign(responses.begin(), responses.end());
+		std::nth_element(r.begin(), r.begin() + (k_ - 1), r.end(), std::greater<float>());
+		const float kth = r[k_ - 1];
+
+		// Keep all strictly better keypoints and as many ties as needed.
+		size_t better = 0;
+		for (size_t i = 0; i < n; ++i)
+			better += (responses[i] > kth);
+		size_t ties = k_ - better;
+
+		std::vector<uchar> mask(n);
+		for (size_t i = 0; i < n; ++i) {
+			uchar tie = (responses[i] == kth) & (ties > 0);
+			ties -= tie;
+			mask[i] = (responses[i] > kth) | tie;
+		}
+		select(mask);
+	}
+
+	/// Keeps only keypoints with given (ascending) indices.
+	void gather(const std::vector<int> & idx_) {
+		gatherColumn(x, idx_);
+		gatherColumn(y, idx_);
+		gatherColumn(sizes, idx_);
+		gatherColumn(angles, idx_);
+		gatherColumn(responses, idx_);
+		gatherColumn(octaves, idx_);
+		gatherColumn(class_ids, idx_);
+	}
+
+	/// Columns.
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> sizes;
+	std::vector<float> angles;
+	std::vector<float> responses;
+	std::vector<int> octaves;
+	std::vector<int> class_ids;
+
+private:
+	/// Compacts the column in place - indices are ascending, so every element is moved towards the front.
+	template <typename T>
+	static void gatherColumn(std::vector<T> & col_, const std::vector<int> & idx_) {
+		T * c = col_.empty() ? NULL : &col_[0];
+		for (size_t i = 0; i < idx_.size(); ++i)
+			c[i] = c[idx_[i]];
+		col_.resize(idx_.size());
+	}
+
+	/// Reused buffers.
+	std::vector<int> indices;
+	std::vector<float> scratch;
+};
+
+} //: namespace Types
+
+#endif /* KEYPOINTSSOA_HPP_ */
@@ -0,0 +1,121 @@
+/*!
+ * \file KeyPoints_bench.cpp
+ * \brief Benchmark of per-frame keypoint copies in a pipeline with 4 consumers - SharedKeyPoints (copy-on-write)
+ * vs deep copies of KeyPoints.
+ *
+ * Every frame is written to 4 data stream buffers (one copy each) and read by 4 consumers (another copy each).
+ * Three consumers only read the keypoints, one of them filters them in place.
+ *
+ * Built when CvCoreTypes_BUILD_BENCHMARKS is enabled.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "KeyPoints.hpp"
+#include "SharedKeyPoints.hpp"
+
+namespace {
+
+const int FRAMES = 200;
+const int KEYPOINTS = 20000;
+const int CONSUMERS = 4;
+
+double seconds(int64 start_) {
+	return (cv::getTickCount() - start_) / cv::getTickFrequency();
+}
+
+std::vector<cv::KeyPoint> randomKeyPoints(int n_) {
+	std::vector<cv::KeyPoint> kps(n_);
+	for (int i = 0; i < n_; ++i)
+		kps[i] = cv::KeyPoint(rand() % 640, rand() % 480, 7, 0, (rand() % 1000) / 1000.0f, rand() % 4);
+	return kps;
+}
+
+/// Reading consumer - sums responses.
+double read(const std::vector<cv::KeyPoint> & kps_) {
+	double sum = 0;
+	for (size_t i = 0; i < kps_.size(); ++i)
+		sum += kps_[i].response;
+	return sum;
+}
+
+/// Modifying consumer - drops weak keypoints.
+double filter(std::vector<cv::KeyPoint> & kps_) {
+	size_t n = 0;
+	for (size_t i = 0; i < kps_.size(); ++i)
+		if (kps_[i].response > 0.5f)
+			kps_[n++] = kps_[i];
+	kps_.resize(n);
+	return (double)n;
+}
+
+/// KeyPoints - every copy duplicates the whole keypoint vector.
+double deepCopies(const Types::KeyPoints & frame_) {
+	double sum = 0;
+	Types::KeyPoints buffers[CONSUMERS];
+	for (int c = 0; c < CONSUMERS; ++c)
+		buffers[c] = frame_;
+	for (int c = 0; c < CONSUMERS; ++c) {
+		Types::KeyPoints kps(buffers[c]);
+		sum += (c == 0) ? filter(kps.keypoints) : read(kps.keypoints);
+	}
+	return sum;
+}
+
+/// SharedKeyPoints - only the filtering consumer copies the keypoints.
+double sharedCopies(const Types::SharedKeyPoints & frame_) {
+	double sum = 0;
+	Types::SharedKeyPoints buffers[CONSUMERS];
+	for (int c = 0; c < CONSUMERS; ++c)
+		buffers[c] = frame_;
+	for (int c = 0; c < CONSUMERS; ++c) {
+		Types::SharedKeyPoints kps(buffers[c]);
+		sum += (c == 0) ? filter(kps.mutableKeyPoints()) : read(kps.get());
+	}
+	return sum;
+}
+
+}
+
+int main() {
+	std::vector<std::vector<cv::KeyPoint> > frames(8);
+	for (size_t i = 0; i < frames.size(); ++i)
+		frames[i] = randomKeyPoints(KEYPOINTS);
+
+	std::vector<Types::KeyPoints> deep_frames(frames.begin(), frames.end());
+	double sum = 0;
+	int64 start = cv::getTickCount();
+	for (int f = 0; f < FRAMES; ++f)
+		sum += deepCopies(deep_frames[f % deep_frames.size()]);
+	double t_deep = seconds(start);
+
+	std::vector<Types::SharedKeyPoints> shared_frames;
+	for (size_t i = 0; i < frames.size(); ++i)
+		shared_frames.push_back(Types::SharedKeyPoints(frames[i]));
+	start = cv::getTickCount();
+	for (int f = 0; f < FRAMES; ++f)
+		sum += sharedCopies(shared_frames[f % shared_frames.size()]);
+	double t_shared = seconds(start);
+
+	// Clones (e.g. when Drawables are collected for visualisation).
+	start = cv::getTickCount();
+	for (int f = 0; f < FRAMES; ++f) {
+		for (int c = 0; c < CONSUMERS; ++c) {
+			Types::Drawable * d = shared_frames[f % shared_frames.size()].clone();
+			sum += static_cast<Types::SharedKeyPoints *>(d)->size();
+			delete d;
+		}
+	}
+	double t_clone = seconds(start);
+
+	printf("%d keypoints, %d consumers, %d copies per frame\n", KEYPOINTS, CONSUMERS, 2 * CONSUMERS);
+	printf("deep copies:   %10.1f us/frame\n", 1e6 * t_deep / FRAMES);
+	printf("shared copies: %10.1f us/frame\n", 1e6 * t_shared / FRAMES);
+	printf("clones:        %10.3f us/clone   (%g)\n", 1e6 * t_clone / (FRAMES * CONSUMERS), sum);
+
+	return 0;
+}
@@ -24,6 +24,13 @@ public:
 		patternSize(patternSize)
 	{
 	}
+
+	/// Creates chessboard with model points taken from the ModelPoints cache (shared, not copied).
+	Chessboard(cv::Size patternSize, float squareSize) :
+		patternSize(patternSize)
+	{
+		setModelPoints(ModelPoints::get(patternSize, squareSize, ModelPoints::CHESSBOARD));
+	}
 	Chessboard(const Chessboard& o) :
 		Object3D(o),
 		patternSize(o.patternSize)
@@ -39,13 +46,19 @@ public:
 		return new Chessboard(*this);
 	}
 
+	virtual boost::shared_ptr<Drawable> cloneHandle()
+	{
+		return DrawablePool<Chessboard>::cloneHandle(*this);
+	}
+
 	virtual void draw(cv::Mat& image, cv::Scalar color, int offsetX = 0, int offsetY = 0)
 	{
-		cv::Mat ip(imagePoints);
+		cv::Mat ip = shiftedImagePoints(offsetX, offsetY);
 		cv::drawChessboardCorners(image, patternSize, ip, true);
 	}
 private:
-	const cv::Size patternSize;
+	// Not const - pooled instances are copy-assigned.
+	cv::Size patternSize;
 };
 
 }
@@ -24,6 +24,13 @@ public:
 		patternSize(patternSize)
 	{
 	}
+
+	/// Creates grid with model points taken from the ModelPoints cache (shared, not copied).
+	GridPattern(cv::Size patternSize, float spacing, ModelPoints::Layout layout = ModelPoints::SYMMETRIC_GRID) :
+		patternSize(patternSize)
+	{
+		setModelPoints(ModelPoints::get(patternSize, spacing, layout));
+	}
 	GridPattern(const GridPattern& o) :
 		Object3D(o),
 		patternSize(o.patternSize)
@@ -39,13 +46,19 @@ public:
 		return new GridPattern(*this);
 	}
 
+	virtual boost::shared_ptr<Drawable> cloneHandle()
+	{
+		return DrawablePool<GridPattern>::cloneHandle(*this);
+	}
+
 	virtual void draw(cv::Mat& image, cv::Scalar color, int offsetX = 0, int offsetY = 0)
 	{
-		cv::Mat ip(imagePoints);
+		cv::Mat ip = shiftedImagePoints(offsetX, offsetY);
 		cv::drawChessboardCorners(image, patternSize, ip, true);
 	}
 private:
-	const cv::Size patternSize;
+	// Not const - pooled instances are copy-assigned.
+	cv::Size patternSize;
 };
 
 }
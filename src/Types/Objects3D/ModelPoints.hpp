@@ -0,0 +1,117 @@
+/*!
+ * \file ModelPoints.hpp
+ * \brief Process-wide cache of model points of planar calibration patterns.
+ */
+
+#ifndef MODELPOINTS_HPP_
+#define MODELPOINTS_HPP_
+
+#include <map>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <opencv2/core/core.hpp>
+
+namespace Types {
+
+namespace Objects3D {
+
+/// Shared, immutable set of model points.
+typedef boost::shared_ptr<const std::vector<cv::Point3f> > ModelPointsPtr;
+
+/*!
+ * \class ModelPoints
+ * \brief Generates model points of planar patterns - once per (pattern size, square size, layout).
+ *
+ * Generated sets are kept for the lifetime of the process and handed out as shared immutable vectors,
+ * so all objects observing the same pattern share a single copy of its geometry.
+ */
+class ModelPoints
+{
+public:
+	/// Arrangement of the points of a pattern.
+	enum Layout {
+		/// Corners of a chessboard, row by row (as returned by cv::findChessboardCorners).
+		CHESSBOARD,
+		/// Symmetric grid of circles - the same geometry as chessboard corners.
+		SYMMETRIC_GRID,
+		/// Asymmetric grid of circles (cv::CALIB_CB_ASYMMETRIC_GRID) - every other row is shifted by half of the spacing.
+		ASYMMETRIC_GRID
+	};
+
+	/*!
+	 * Returns model points of the pattern lying in the Z = 0 plane, with the first point at the origin.
+	 * \param patternSize_ number of points per row (width) and column (height)
+	 * \param squareSize_ distance between neighbouring points
+	 */
+	static ModelPointsPtr get(cv::Size patternSize_, float squareSize_, Layout layout_ = CHESSBOARD)
+	{
+		const Key key(patternSize_.width, patternSize_.height, squareSize_, layout_ == SYMMETRIC_GRID ? CHESSBOARD : layout_);
+
+		Cache & c = cache();
+		boost::mutex::scoped_lock lock(c.mutex);
+		ModelPointsPtr & points = c.sets[key];
+		if (!points) {
+			points = generate(patternSize_, squareSize_, key.layout);
+		}
+		return points;
+	}
+
+	/// Generates model points without caching them.
+	static ModelPointsPtr generate(cv::Size patternSize_, float squareSize_, Layout layout_ = CHESSBOARD)
+	{
+		boost::shared_ptr<std::vector<cv::Point3f> > points(new std::vector<cv::Point3f>);
+		points->reserve(patternSize_.area());
+		for (int i = 0; i < patternSize_.height; ++i) {
+			for (int j = 0; j < patternSize_.width; ++j) {
+				const float x = (layout_ == ASYMMETRIC_GRID) ? (2 * j + i % 2) * squareSize_ : j * squareSize_;
+				points->push_back(cv::Point3f(x, i * squareSize_, 0));
+			}
+		}
+		return points;
+	}
+
+private:
+	struct Key {
+		Key(int width_, int height_, float squareSize_, Layout layout_) :
+			width(width_), height(height_), squareSize(squareSize_), layout(layout_)
+		{
+		}
+
+		bool operator<(const Key & other_) const
+		{
+			if (width != other_.width)
+				return width < other_.width;
+			if (height != other_.height)
+				return height < other_.height;
+			if (squareSize != other_.squareSize)
+				return squareSize < other_.squareSize;
+			return layout < other_.layout;
+		}
+
+		int width;
+		int height;
+		float squareSize;
+		Layout layout;
+	};
+
+	struct Cache {
+		boost::mutex mutex;
+		std::map<Key, ModelPointsPtr> sets;
+	};
+
+	/// The cache is never destroyed, so model points can be requested at any time, even at exit.
+	static Cache & cache()
+	{
+		static Cache * c = new Cache;
+		return *c;
+	}
+};
+
+}
+
+}
+
+#endif /* MODELPOINTS_HPP_ */
@@ -10,49 +10,84 @@
 
 #include <stdexcept>
 
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/calib3d/calib3d.hpp>
+
+#include "Types/CameraInfo.hpp"
 #include "Types/Drawable.hpp"
+#include "Types/DrawablePool.hpp"
+#include "Types/HomogMatrix.hpp"
+#include "Types/Objects3D/ModelPoints.hpp"
+#include "Types/Objects3D/Reprojection.hpp"
 
 namespace Types {
 
 namespace Objects3D {
 
-//struct HomogMatrix
-//{
-//	double elements[3][4];
-//};
-
+/*!
+ * Object with known model points, observed in the image.
+ *
+ * The pose of the object (model to camera transformation) is computed lazily by getPosition(camera)
+ * and cached until the points or the camera change. Each solution is also kept as the initial guess
+ * for the next one, so when the object is tracked across frames (points of the new frame set on the same
+ * instance) solvePnP only refines the previous pose instead of solving from scratch. A refined pose whose
+ * RMS reprojection error exceeds setMaxRefinementError() is dropped and the pose is solved from scratch.
+ *
+ * Model points are held through a shared immutable handle (see ModelPoints), so copying an object
+ * does not copy its model geometry.
+ */
 class Object3D : public Types::Drawable
 {
 public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
 	Object3D() :
-		imagePointsSet(false), modelPointsSet(false), positionSet(false)
+		imagePointsSet(false), modelPointsSet(false), positionSet(false), modelPointsOwned(false), guessSet(false),
+		maxRefinementError(2.0)
 	{
 	}
 
-	Object3D(const Object3D& o)
+	Object3D(const Object3D& o) :
+		Drawable(o)
 	{
 		imagePointsSet = o.imagePointsSet;
-		modelPointsSet = o.imagePointsSet;
+		modelPointsSet = o.modelPointsSet;
 		positionSet = o.positionSet;
 		imagePoints = o.imagePoints;
 		modelPoints = o.modelPoints;
-//		position = o.position;
+		modelPointsOwned = o.modelPointsOwned;
+		position = o.position;
+		guessSet = o.guessSet;
+		maxRefinementError = o.maxRefinementError;
+		o.rvec.copyTo(rvec);
+		o.tvec.copyTo(tvec);
+		o.positionCamera.copyTo(positionCamera);
+		o.positionDist.copyTo(positionDist);
 	}
 
 	virtual ~Object3D()
 	{
 	}
 
-//	const Object3D& operator=(const Object3D& o)
-//	{
-//		imagePointsSet = o.imagePointsSet;
-//		modelPointsSet = o.imagePointsSet;
-//		positionSet = o.positionSet;
-//		imagePoints = o.imagePoints;
-//		modelPoints = o.modelPoints;
-//		position = o.position;
-//		return *this;
-//	}
+	/// Copy-assignment - also used by the pool, so the buffers of this instance are reused.
+	Object3D& operator=(const Object3D& o)
+	{
+		Drawable::operator=(o);
+		imagePointsSet = o.imagePointsSet;
+		modelPointsSet = o.modelPointsSet;
+		positionSet = o.positionSet;
+		imagePoints = o.imagePoints;
+		modelPoints = o.modelPoints;
+		modelPointsOwned = o.modelPointsOwned;
+		position = o.position;
+		guessSet = o.guessSet;
+		maxRefinementError = o.maxRefinementError;
+		o.rvec.copyTo(rvec);
+		o.tvec.copyTo(tvec);
+		o.positionCamera.copyTo(positionCamera);
+		o.positionDist.copyTo(positionDist);
+		return *this;
+	}
 
 	void setImagePoints(const std::vector <cv::Point2f>& imagePoints)
 	{
@@ -70,12 +105,39 @@ public:
 
 	void setModelPoints(const std::vector <cv::Point3f>& modelPoints)
 	{
+		if (modelPointsOwned && this->modelPoints.unique()) {
+			// Allocated here and not shared with anyone - reuse the buffer.
+			const_cast<std::vector <cv::Point3f>&>(*this->modelPoints) = modelPoints;
+		} else {
+			this->modelPoints.reset(new std::vector <cv::Point3f>(modelPoints));
+			modelPointsOwned = true;
+		}
+		modelPointsSet = true;
+		positionSet = false;
+	}
+
+	/// Shares the given model points (e.g. taken from ModelPoints::get()) instead of copying them.
+	void setModelPoints(const ModelPointsPtr& modelPoints)
+	{
+		if (!modelPoints) {
+			throw std::invalid_argument("modelPoints must not be NULL.");
+		}
 		this->modelPoints = modelPoints;
+		modelPointsOwned = false;
 		modelPointsSet = true;
 		positionSet = false;
 	}
 
 	const std::vector <cv::Point3f>& getModelPoints() const
+	{
+		if (!modelPointsSet) {
+			throw std::logic_error("modelPoints has not been set.");
+		}
+		return *modelPoints;
+	}
+
+	/// Returns the shared handle of model points.
+	ModelPointsPtr getModelPointsHandle() const
 	{
 		if (!modelPointsSet) {
 			throw std::logic_error("modelPoints has not been set.");
@@ -88,36 +150,233 @@ public:
 		return new Object3D(*this);
 	}
 
+	virtual boost::shared_ptr<Drawable> cloneHandle()
+	{
+		return DrawablePool<Object3D>::cloneHandle(*this);
+	}
+
+	/// Clears the points, keeping capacity of the image points (model points are shared, so they are just released).
+	virtual void recycle()
+	{
+		imagePoints.clear();
+		modelPoints.reset();
+		modelPointsOwned = false;
+		imagePointsSet = false;
+		modelPointsSet = false;
+		positionSet = false;
+		guessSet = false;
+	}
+
 	virtual void draw(cv::Mat& image, cv::Scalar color, int offsetX = 0, int offsetY = 0)
 	{
 		// TODO?
 	}
 
+	/// Bounding box of image points, enlarged by the size of the drawn markers.
+	virtual cv::Rect bounds(int offsetX = 0, int offsetY = 0) const
+	{
+		if (imagePoints.empty()) {
+			return cv::Rect();
+		}
+		cv::Rect r = cv::boundingRect(imagePoints);
+		const int m = MARKER_SIZE;
+		return cv::Rect(r.x + offsetX - m, r.y + offsetY - m, r.width + 2 * m, r.height + 2 * m);
+	}
 
-//	void setPosition(const HomogMatrix& position)
-//	{
-//		this->position = position;
-//		positionSet = true;
-//	}
 
-//	const HomogMatrix& getPosition() const
-//	{
-//		if (!positionSet) {
-//			throw std::logic_error("position has not been set.");
-//		}
-//		return position;
-//	}
+	/// Sets the pose, it is also used as the initial guess of the next solution.
+	void setPosition(const HomogMatrix& position)
+	{
+		this->position = position;
+		positionSet = true;
+		positionCamera.release();
+		positionDist.release();
+		setPoseGuess(position);
+	}
 
-//	virtual Object3D* clone() = 0;
+	/// Returns the pose set by setPosition() or computed by the last getPosition(camera).
+	const HomogMatrix& getPosition() const
+	{
+		if (!positionSet) {
+			throw std::logic_error("position has not been set.");
+		}
+		return position;
+	}
+
+	/*!
+	 * Returns the pose of the object in the camera frame, computed from image and model points.
+	 * The result is cached until the points or the camera parameters change.
+	 * \throws std::logic_error if points were not set or there are less than 4 of them
+	 */
+	const HomogMatrix& getPosition(const CameraInfo& camera)
+	{
+		cv::Mat K = camera.cameraMatrix();
+		cv::Mat D = camera.distCoeffs();
+		if (positionSet && sameMat(K, positionCamera) && sameMat(D, positionDist)) {
+			return position;
+		}
+
+		const std::vector <cv::Point2f>& ip = getImagePoints();
+		const std::vector <cv::Point3f>& mp = getModelPoints();
+		if (ip.size() != mp.size() || ip.size() < 4) {
+			throw std::logic_error("at least 4 corresponding image and model points are required to compute position.");
+		}
+
+		// Refine the previous pose. The iterative solver may fail or converge to a wrong local minimum
+		// (e.g. after a fast motion), so the refined pose is kept only if it reprojects well.
+		bool solved = false;
+		if (guessSet && cv::solvePnP(mp, ip, K, D, rvec, tvec, true)) {
+			setPositionFromVectors();
+			solved = reprojectionError(camera, position).rms <= maxRefinementError;
+		}
+		// Otherwise solve from scratch.
+		if (!solved) {
+			if (!cv::solvePnP(mp, ip, K, D, rvec, tvec, false)) {
+				guessSet = false;
+				throw std::runtime_error("solvePnP failed to compute position.");
+			}
+			setPositionFromVectors();
+		}
+
+		guessSet = true;
+		positionSet = true;
+		K.copyTo(positionCamera);
+		D.copyTo(positionDist);
+		return position;
+	}
+
+	/// Sets the initial guess of the next pose computation (e.g. the pose predicted from the previous frame).
+	void setPoseGuess(const HomogMatrix& guess)
+	{
+		cv::Matx33d R;
+		for (int i = 0; i < 3; ++i) {
+			for (int j = 0; j < 3; ++j) {
+				R(i, j) = guess.matrix()(i, j);
+			}
+		}
+		cv::Rodrigues(cv::Mat(R), rvec);
+		tvec.create(3, 1, CV_64F);
+		for (int i = 0; i < 3; ++i) {
+			tvec.at<double>(i) = guess.matrix()(i, 3);
+		}
+		guessSet = true;
+	}
+
+	/// Drops the initial guess - the next pose is computed from scratch (e.g. after the object was lost).
+	void resetPoseGuess()
+	{
+		guessSet = false;
+	}
+
+	/// Sets the largest RMS reprojection error (in pixels) of a pose refined from the guess.
+	/// A refined pose with a larger error is dropped and the pose is solved from scratch.
+	void setMaxRefinementError(double maxRefinementError)
+	{
+		this->maxRefinementError = maxRefinementError;
+	}
+
+	double getMaxRefinementError() const
+	{
+		return maxRefinementError;
+	}
+
+	/*!
+	 * Projects model points with the given pose and compares them with image points (see Reprojection).
+	 * \param residuals if not NULL, per-point errors are stored there (one for each image point)
+	 * \throws std::logic_error if points were not set or their numbers differ
+	 */
+	ReprojectionError reprojectionError(const Reprojection::Camera& camera, const HomogMatrix& pose, float* residuals = NULL) const
+	{
+		const std::vector <cv::Point2f>& ip = getImagePoints();
+		const std::vector <cv::Point3f>& mp = getModelPoints();
+		if (ip.size() != mp.size()) {
+			throw std::logic_error("numbers of image and model points differ.");
+		}
+		return Reprojection::evaluate(camera, pose, mp.empty() ? NULL : &mp[0], ip.empty() ? NULL : &ip[0], ip.size(), residuals);
+	}
+
+	ReprojectionError reprojectionError(const CameraInfo& camera, const HomogMatrix& pose, float* residuals = NULL) const
+	{
+		return reprojectionError(Reprojection::Camera(camera), pose, residuals);
+	}
+
+	/// Per-point errors are stored in the vector (it allocates only when it has to grow).
+	ReprojectionError reprojectionError(const CameraInfo& camera, const HomogMatrix& pose, std::vector<float>& residuals) const
+	{
+		residuals.resize(getImagePoints().size());
+		return reprojectionError(Reprojection::Camera(camera), pose, residuals.empty() ? NULL : &residuals[0]);
+	}
+
+	/*!
+	 * Evaluates reprojection errors of many objects observed by the same camera - camera parameters are prepared once.
+	 * \param poses poses of the objects, if NULL the positions of the objects (getPosition()) are used
+	 */
+	static void reprojectionErrors(const CameraInfo& camera, const Object3D* const* objects, size_t count,
+			ReprojectionError* results, const HomogMatrix* const* poses = NULL)
+	{
+		const Reprojection::Camera cam(camera);
+		for (size_t i = 0; i < count; ++i) {
+			results[i] = objects[i]->reprojectionError(cam, poses ? *poses[i] : objects[i]->getPosition());
+		}
+	}
 
 protected:
+	/// Returns image points moved by the offsets (without copying them if there is no offset).
+	cv::Mat shiftedImagePoints(int offsetX, int offsetY) const
+	{
+		if (offsetX == 0 && offsetY == 0) {
+			return cv::Mat(imagePoints);
+		}
+		cv::Mat ip = cv::Mat(imagePoints).clone();
+		ip += cv::Scalar(offsetX, offsetY);
+		return ip;
+	}
+
+	/// Size of markers drawn at image points (e.g. by cv::drawChessboardCorners).
+	static const int MARKER_SIZE = 8;
+
+	/// Sets the position from the current rotation and translation vectors.
+	void setPositionFromVectors()
+	{
+		cv::Matx33d R;
+		cv::Rodrigues(rvec, R);
+		for (int i = 0; i < 3; ++i) {
+			for (int j = 0; j < 3; ++j) {
+				position.matrix()(i, j) = R(i, j);
+			}
+			position.matrix()(i, 3) = tvec.at<double>(i);
+		}
+	}
+
+	/// Checks whether the camera parameters did not change since the pose was computed.
+	static bool sameMat(const cv::Mat& a, const cv::Mat& b)
+	{
+		if (a.size() != b.size() || a.type() != b.type()) {
+			return false;
+		}
+		return a.empty() || cv::norm(a, b, cv::NORM_INF) == 0;
+	}
+
 	bool imagePointsSet;
 	bool modelPointsSet;
 	bool positionSet;
 
 	std::vector <cv::Point2f> imagePoints;
-	std::vector <cv::Point3f> modelPoints;
-//	HomogMatrix position;
+	ModelPointsPtr modelPoints;
+	/// Model points were allocated by setModelPoints(vector), so they may be modified when not shared.
+	bool modelPointsOwned;
+	HomogMatrix position;
+
+	/// Previous solution (rotation and translation vectors), used as the initial guess of solvePnP.
+	bool guessSet;
+	cv::Mat rvec;
+	cv::Mat tvec;
+	/// Largest RMS reprojection error of a pose refined from the guess (2 px by default).
+	double maxRefinementError;
+
+	/// Camera parameters the cached position was computed with.
+	cv::Mat positionCamera;
+	cv::Mat positionDist;
 };
 
 }
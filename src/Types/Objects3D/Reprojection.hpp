@@ -0,0 +1,254 @@
+/*!
+ * \file Reprojection.hpp
+ * \brief Fused projection of model points and comparison with image points (reprojection error).
+ */
+
+#ifndef REPROJECTION_HPP_
+#define REPROJECTION_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/calib3d/calib3d.hpp>
+
+#include "Types/CameraInfo.hpp"
+#include "Types/HomogMatrix.hpp"
+
+namespace Types {
+
+namespace Objects3D {
+
+/// Reprojection error of a set of points (in pixels).
+struct ReprojectionError
+{
+	ReprojectionError() :
+		rms(0), max(0), points(0)
+	{
+	}
+
+	/// Root mean square of the residuals.
+	double rms;
+	/// Largest residual.
+	double max;
+	/// Number of evaluated points.
+	size_t points;
+};
+
+/*!
+ * \class Reprojection
+ * \brief Projects model points with the camera model of cv::projectPoints and compares them with image points in a single pass.
+ *
+ * Intrinsics and distortion are extracted from CameraInfo once (see Camera), the pose is converted once per call -
+ * the per-point loop does not allocate and, if __AVX2__ and __FMA__ are defined, processes 8 points at a time.
+ * Computations are done in single precision. Distortion models with more than 5 coefficients
+ * (rational, thin prism, tilted) are handled by cv::projectPoints.
+ */
+class Reprojection
+{
+public:
+	/// Camera parameters in the form used by the kernel.
+	struct Camera
+	{
+		explicit Camera(const CameraInfo& camera_)
+		{
+			const cv::Mat K = camera_.cameraMatrix();
+			fx = (float) at(K, 0, 0);
+			skew = (float) at(K, 0, 1);
+			cx = (float) at(K, 0, 2);
+			fy = (float) at(K, 1, 1);
+			cy = (float) at(K, 1, 2);
+
+			const cv::Mat D = camera_.distCoeffs();
+			const int n = (int) D.total();
+			float d[5] = { 0, 0, 0, 0, 0 };
+			simple = true;
+			for (int i = 0; i < n; ++i) {
+				const double v = (D.cols == 1) ? at(D, i, 0) : at(D, 0, i);
+				if (i < 5)
+					d[i] = (float) v;
+				else if (v != 0)
+					simple = false;
+			}
+			k1 = d[0]; k2 = d[1]; p1 = d[2]; p2 = d[3]; k3 = d[4];
+
+			if (!simple) {
+				K.convertTo(cameraMatrix, CV_64F);
+				D.convertTo(distCoeffs, CV_64F);
+			}
+		}
+
+		float fx, fy, cx, cy, skew;
+		float k1, k2, p1, p2, k3;
+
+		/// False if the distortion model has more than 5 coefficients - cv::projectPoints is used then.
+		bool simple;
+		cv::Mat cameraMatrix;
+		cv::Mat distCoeffs;
+
+	private:
+		static double at(const cv::Mat& m_, int row_, int col_)
+		{
+			return (m_.depth() == CV_64F) ? m_.at<double>(row_, col_) : m_.at<float>(row_, col_);
+		}
+	};
+
+	/*!
+	 * Projects model points with the given pose and compares them with image points.
+	 * \param residuals_ if not NULL, distances between projected and image points are stored there (count_ elements)
+	 */
+	static ReprojectionError evaluate(const Camera& camera_, const HomogMatrix& pose_,
+			const cv::Point3f* model_, const cv::Point2f* image_, size_t count_, float* residuals_ = NULL)
+	{
+		ReprojectionError result;
+		result.points = count_;
+		if (count_ == 0)
+			return result;
+
+		if (!camera_.simple)
+			return evaluateGeneric(camera_, pose_, model_, image_, count_, residuals_);
+
+		float r[12];
+		for (int i = 0; i < 3; ++i) {
+			for (int j = 0; j < 4; ++j) {
+				r[i * 4 + j] = (float) pose_.matrix()(i, j);
+			}
+		}
+
+		double sum = 0;
+		float max = 0;
+		size_t i = 0;
+
+#if defined(__AVX2__) && defined(__FMA__)
+		const __m256i idx3 = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+		const __m256i idx2 = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+		const __m256 one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f);
+		__m256d vsum = _mm256_setzero_pd();
+		__m256 vmax = _mm256_setzero_ps();
+		for (; i + 8 <= count_; i += 8) {
+			const float* m = &model_[i].x;
+			const float* im = &image_[i].x;
+			const __m256 X = _mm256_i32gather_ps(m, idx3, 4);
+			const __m256 Y = _mm256_i32gather_ps(m + 1, idx3, 4);
+			const __m256 Z = _mm256_i32gather_ps(m + 2, idx3, 4);
+
+			// Camera coordinates.
+			const __m256 cx = _mm256_fmadd_ps(_mm256_set1_ps(r[0]), X, _mm256_fmadd_ps(_mm256_set1_ps(r[1]), Y,
+					_mm256_fmadd_ps(_mm256_set1_ps(r[2]), Z, _mm256_set1_ps(r[3]))));
+			const __m256 cy = _mm256_fmadd_ps(_mm256_set1_ps(r[4]), X, _mm256_fmadd_ps(_mm256_set1_ps(r[5]), Y,
+					_mm256_fmadd_ps(_mm256_set1_ps(r[6]), Z, _mm256_set1_ps(r[7]))));
+			const __m256 cz = _mm256_fmadd_ps(_mm256_set1_ps(r[8]), X, _mm256_fmadd_ps(_mm256_set1_ps(r[9]), Y,
+					_mm256_fmadd_ps(_mm256_set1_ps(r[10]), Z, _mm256_set1_ps(r[11]))));
+
+			// Normalized coordinates and distortion.
+			const __m256 iz = _mm256_div_ps(one, cz);
+			const __m256 x = _mm256_mul_ps(cx, iz);
+			const __m256 y = _mm256_mul_ps(cy, iz);
+			const __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), xy = _mm256_mul_ps(x, y);
+			const __m256 r2 = _mm256_add_ps(xx, yy);
+			const __m256 radial = _mm256_fmadd_ps(r2, _mm256_fmadd_ps(r2, _mm256_fmadd_ps(r2, _mm256_set1_ps(camera_.k3),
+					_mm256_set1_ps(camera_.k2)), _mm256_set1_ps(camera_.k1)), one);
+			const __m256 xd = _mm256_fmadd_ps(x, radial, _mm256_fmadd_ps(_mm256_set1_ps(2 * camera_.p1), xy,
+					_mm256_mul_ps(_mm256_set1_ps(camera_.p2), _mm256_fmadd_ps(two, xx, r2))));
+			const __m256 yd = _mm256_fmadd_ps(y, radial, _mm256_fmadd_ps(_mm256_set1_ps(2 * camera_.p2), xy,
+					_mm256_mul_ps(_mm256_set1_ps(camera_.p1), _mm256_fmadd_ps(two, yy, r2))));
+
+			// Pixel coordinates and residuals.
+			const __m256 u = _mm256_fmadd_ps(_mm256_set1_ps(camera_.fx), xd,
+					_mm256_fmadd_ps(_mm256_set1_ps(camera_.skew), yd, _mm256_set1_ps(camera_.cx)));
+			const __m256 v = _mm256_fmadd_ps(_mm256_set1_ps(camera_.fy), yd, _mm256_set1_ps(camera_.cy));
+			const __m256 du = _mm256_sub_ps(u, _mm256_i32gather_ps(im, idx2, 4));
+			const __m256 dv = _mm256_sub_ps(v, _mm256_i32gather_ps(im + 1, idx2, 4));
+			const __m256 e2 = _mm256_fmadd_ps(du, du, _mm256_mul_ps(dv, dv));
+
+			vsum = _mm256_add_pd(vsum, _mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(e2)),
+					_mm256_cvtps_pd(_mm256_extractf128_ps(e2, 1))));
+			vmax = _mm256_max_ps(vmax, e2);
+			if (residuals_)
+				_mm256_storeu_ps(residuals_ + i, _mm256_sqrt_ps(e2));
+		}
+
+		double s[4];
+		_mm256_storeu_pd(s, vsum);
+		sum = (s[0] + s[1]) + (s[2] + s[3]);
+		float m[8];
+		_mm256_storeu_ps(m, vmax);
+		max = *std::max_element(m, m + 8);
+#endif
+
+		for (; i < count_; ++i) {
+			const cv::Point3f& P = model_[i];
+			const float cx = r[0] * P.x + r[1] * P.y + r[2] * P.z + r[3];
+			const float cy = r[4] * P.x + r[5] * P.y + r[6] * P.z + r[7];
+			const float cz = r[8] * P.x + r[9] * P.y + r[10] * P.z + r[11];
+
+			const float iz = 1.0f / cz;
+			const float x = cx * iz, y = cy * iz;
+			const float xx = x * x, yy = y * y, xy = x * y;
+			const float r2 = xx + yy;
+			const float radial = 1 + r2 * (camera_.k1 + r2 * (camera_.k2 + r2 * camera_.k3));
+			const float xd = x * radial + 2 * camera_.p1 * xy + camera_.p2 * (r2 + 2 * xx);
+			const float yd = y * radial + 2 * camera_.p2 * xy + camera_.p1 * (r2 + 2 * yy);
+
+			const float du = camera_.fx * xd + camera_.skew * yd + camera_.cx - image_[i].x;
+			const float dv = camera_.fy * yd + camera_.cy - image_[i].y;
+			const float e2 = du * du + dv * dv;
+			sum += e2;
+			max = std::max(max, e2);
+			if (residuals_)
+				residuals_[i] = std::sqrt(e2);
+		}
+
+		result.rms = std::sqrt(sum / count_);
+		result.max = std::sqrt(max);
+		return result;
+	}
+
+private:
+	/// Evaluation with cv::projectPoints (full distortion model).
+	static ReprojectionError evaluateGeneric(const Camera& camera_, const HomogMatrix& pose_,
+			const cv::Point3f* model_, const cv::Point2f* image_, size_t count_, float* residuals_)
+	{
+		cv::Matx33d R;
+		cv::Vec3d t;
+		for (int i = 0; i < 3; ++i) {
+			for (int j = 0; j < 3; ++j) {
+				R(i, j) = pose_.matrix()(i, j);
+			}
+			t[i] = pose_.matrix()(i, 3);
+		}
+		cv::Vec3d rvec;
+		cv::Rodrigues(R, rvec);
+
+		std::vector<cv::Point2f> projected;
+		cv::projectPoints(cv::Mat((int) count_, 1, CV_32FC3, (void*) model_), rvec, t,
+				camera_.cameraMatrix, camera_.distCoeffs, projected);
+
+		ReprojectionError result;
+		result.points = count_;
+		double sum = 0;
+		for (size_t i = 0; i < count_; ++i) {
+			const double dx = projected[i].x - image_[i].x, dy = projected[i].y - image_[i].y;
+			const double e2 = dx * dx + dy * dy;
+			sum += e2;
+			result.max = std::max(result.max, e2);
+			if (residuals_)
+				residuals_[i] = (float) std::sqrt(e2);
+		}
+		result.rms = std::sqrt(sum / count_);
+		result.max = std::sqrt(result.max);
+		return result;
+	}
+};
+
+}
+
+}
+
+#endif /* REPROJECTION_HPP_ */
@@ -0,0 +1,61 @@
+/*!
+ * \file PoolSpinLock.hpp
+ * \brief Spin lock guarding memory pools.
+ */
+
+#ifndef POOLSPINLOCK_HPP_
+#define POOLSPINLOCK_HPP_
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace Types {
+
+/*!
+ * \class PoolSpinLock
+ * \brief Minimal spin lock guarding the pools - critical sections are just a few pointer operations,
+ * so spinning is cheaper than a system mutex.
+ */
+class PoolSpinLock : private boost::noncopyable {
+public:
+	/*!
+	 * \class Guard
+	 * \brief Holds the lock from its construction to its destruction.
+	 */
+	class Guard : private boost::noncopyable {
+	public:
+		explicit Guard(PoolSpinLock & lock_) :
+			lock(lock_)
+		{
+			lock.lock();
+		}
+
+		~Guard() {
+			lock.unlock();
+		}
+
+	private:
+		PoolSpinLock & lock;
+	};
+
+	PoolSpinLock()
+	{
+		flag.clear(boost::memory_order_relaxed);
+	}
+
+	void lock() {
+		while (flag.test_and_set(boost::memory_order_acquire))
+			;
+	}
+
+	void unlock() {
+		flag.clear(boost::memory_order_release);
+	}
+
+private:
+	boost::atomic_flag flag;
+};
+
+} //: namespace Types
+
+#endif /* POOLSPINLOCK_HPP_ */
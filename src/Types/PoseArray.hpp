@@ -0,0 +1,117 @@
+/*!
+ * \file PoseArray.hpp
+ * \brief Contiguous block of poses (homogenous matrices) with optional timestamps, published as a single message.
+ */
+
+#ifndef POSEARRAY_HPP_
+#define POSEARRAY_HPP_
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "HomogMatrix.hpp"
+#include "HomogMatrixContainers.hpp"
+
+namespace Types {
+
+/*!
+ * \class PoseArray
+ * \brief Read-only window [first, first + size) of a shared, aligned block of poses (taken from the AlignedPool).
+ *
+ * Copying the array (e.g. when it is written to a data stream) copies only the pointers, so a whole trajectory
+ * can be handed over to any number of consumers at the cost of a single message. Windows of the same block
+ * (see window()) share it as well. Timestamps, if present, are indexed in the same way as the poses.
+ */
+class PoseArray {
+public:
+	typedef HomogMatrixVector Poses;
+	typedef boost::shared_ptr<const Poses> PosesPtr;
+	typedef boost::shared_ptr<const std::vector<double> > TimestampsPtr;
+
+	typedef const HomogMatrix * const_iterator;
+
+	PoseArray() :
+		m_first(0), m_size(0), m_index(0)
+	{
+	}
+
+	/*!
+	 * Creates window of the block.
+	 * \param poses_ block of poses
+	 * \param first_ first pose of the window
+	 * \param size_ number of poses in the window (truncated to the end of the block)
+	 * \param timestamps_ timestamps of the poses of the block (optional)
+	 * \param index_ index of the first pose of the window in the source sequence
+	 */
+	PoseArray(const PosesPtr & poses_, size_t first_, size_t size_, const TimestampsPtr & timestamps_ = TimestampsPtr(),
+			size_t index_ = 0) :
+		m_poses(poses_), m_timestamps(timestamps_), m_first(0), m_size(0), m_index(index_)
+	{
+		const size_t n = poses_ ? poses_->size() : 0;
+		if (timestamps_ && timestamps_->size() != n)
+			throw std::invalid_argument("PoseArray: number of timestamps differs from the number of poses");
+		m_first = std::min(first_, n);
+		m_size = std::min(size_, n - m_first);
+	}
+
+	/// Number of poses.
+	size_t size() const {
+		return m_size;
+	}
+
+	bool empty() const {
+		return m_size == 0;
+	}
+
+	const HomogMatrix & operator[](size_t i_) const {
+		return (*m_poses)[m_first + i_];
+	}
+
+	/// Contiguous, aligned poses of the window.
+	const HomogMatrix * data() const {
+		return m_size ? &(*m_poses)[m_first] : NULL;
+	}
+
+	const_iterator begin() const {
+		return data();
+	}
+
+	const_iterator end() const {
+		return data() + m_size;
+	}
+
+	bool hasTimestamps() const {
+		return (bool) m_timestamps;
+	}
+
+	/// Timestamp of the pose (0 if poses are not timestamped).
+	double timestamp(size_t i_) const {
+		return m_timestamps ? (*m_timestamps)[m_first + i_] : 0;
+	}
+
+	/// Index of the first pose in the source sequence.
+	size_t index() const {
+		return m_index;
+	}
+
+	/// Returns sub-window [first, first + size) of this window, sharing the block.
+	PoseArray window(size_t first_, size_t size_) const {
+		first_ = std::min(first_, m_size);
+		return PoseArray(m_poses, m_first + first_, std::min(size_, m_size - first_), m_timestamps, m_index + first_);
+	}
+
+private:
+	PosesPtr m_poses;
+	TimestampsPtr m_timestamps;
+
+	size_t m_first;
+	size_t m_size;
+	size_t m_index;
+};
+
+} //: namespace Types
+
+#endif /* POSEARRAY_HPP_ */
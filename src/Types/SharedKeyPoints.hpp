@@ -0,0 +1,125 @@
+/*!
+ * \file SharedKeyPoints.hpp
+ * \brief Drawable set of keypoints sharing a copy-on-write buffer - for fanning keypoints out without copies.
+ */
+
+#ifndef SHAREDKEYPOINTS_HPP_
+#define SHAREDKEYPOINTS_HPP_
+
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <opencv2/core/core.hpp>
+
+#include "Drawable.hpp"
+#include "DrawablePool.hpp"
+#include "KeyPoints.hpp"
+#include "SharedVector.hpp"
+
+namespace Types {
+
+/*!
+ * \class SharedKeyPoints
+ * \brief Handle of keypoints stored in a copy-on-write buffer.
+ *
+ * Copies (e.g. made when a frame's features are fanned out through data streams) and clones share
+ * the buffer until one of them is modified with mutableKeyPoints(); reads never copy it.
+ * Convert to KeyPoints (toKeyPoints()) where a plain, modifiable vector is needed.
+ */
+class SharedKeyPoints : public Drawable {
+public:
+	SharedKeyPoints()
+	{
+	}
+
+	/// Copies keypoints of the set.
+	explicit SharedKeyPoints(const KeyPoints & keypoints_) :
+		Drawable(keypoints_), keypoints(keypoints_.keypoints)
+	{
+	}
+
+	explicit SharedKeyPoints(const std::vector<cv::KeyPoint> & keypoints_) :
+		keypoints(keypoints_)
+	{
+	}
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+	/// Takes over keypoints of the set.
+	explicit SharedKeyPoints(KeyPoints && keypoints_) :
+		Drawable(keypoints_), keypoints(std::move(keypoints_.keypoints))
+	{
+	}
+
+	explicit SharedKeyPoints(std::vector<cv::KeyPoint> && keypoints_) :
+		keypoints(std::move(keypoints_))
+	{
+	}
+#endif
+
+	virtual ~SharedKeyPoints() {}
+
+	/// Read-only access to the keypoints.
+	const std::vector<cv::KeyPoint> & get() const {
+		return keypoints.get();
+	}
+
+	/// Write access to the keypoints - copies the buffer if it is shared.
+	std::vector<cv::KeyPoint> & mutableKeyPoints() {
+		return keypoints.mutableVector();
+	}
+
+	/// Takes over the vector, leaving the previous keypoints in it.
+	void swap(std::vector<cv::KeyPoint> & keypoints_) {
+		keypoints.swap(keypoints_);
+	}
+
+	size_t size() const {
+		return keypoints.size();
+	}
+
+	bool empty() const {
+		return keypoints.empty();
+	}
+
+	/// Number of handles sharing the buffer.
+	long use_count() const {
+		return keypoints.use_count();
+	}
+
+	/// Returns plain copy of the keypoints.
+	KeyPoints toKeyPoints() const {
+		KeyPoints kps(keypoints.get());
+		kps.setCol(m_col);
+		return kps;
+	}
+
+	virtual void draw(cv::Mat & image, cv::Scalar color, int offsetX = 0, int offsetY = 0) {
+		KeyPoints::draw(keypoints.get(), image, color, offsetX, offsetY);
+	}
+
+	virtual cv::Rect bounds(int offsetX = 0, int offsetY = 0) const {
+		return KeyPoints::bounds(keypoints.get(), offsetX, offsetY);
+	}
+
+	virtual Drawable * clone() {
+		return new SharedKeyPoints(*this);
+	}
+
+	virtual boost::shared_ptr<Drawable> cloneHandle() {
+		return DrawablePool<SharedKeyPoints>::cloneHandle(*this);
+	}
+
+	virtual void recycle() {
+		// Releases the buffer if it is shared, keeps its capacity otherwise.
+		keypoints.clear();
+	}
+
+private:
+	SharedVector<cv::KeyPoint> keypoints;
+};
+
+} //: namespace Types
+
+#endif /* SHAREDKEYPOINTS_HPP_ */
@@ -0,0 +1,159 @@
+/*!
+ * \file SharedVector.hpp
+ * \brief Copy-on-write vector - copies share a single buffer until one of them is modified.
+ */
+
+#ifndef SHAREDVECTOR_HPP_
+#define SHAREDVECTOR_HPP_
+
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/shared_ptr.hpp>
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+#include <utility>
+#endif
+
+namespace Types {
+
+/*!
+ * \class SharedVector
+ * \brief Copy-on-write wrapper of std::vector.
+ *
+ * Copying costs a reference count increment. Element access is read-only (also on non-const instances),
+ * so reads never copy the buffer; it is copied (detached) only when a shared instance is modified through
+ * mutableVector() or one of the modifying methods. The object converts implicitly to const std::vector<T>&,
+ * so it can be passed wherever a const vector reference is expected.
+ *
+ * As with every COW container, references obtained from mutableVector() must not be kept across copies.
+ */
+template <typename T>
+class SharedVector {
+public:
+	typedef std::vector<T> vector_type;
+	typedef typename vector_type::value_type value_type;
+	typedef typename vector_type::size_type size_type;
+	typedef typename vector_type::const_reference const_reference;
+	typedef typename vector_type::const_iterator const_iterator;
+
+	SharedVector()
+	{
+	}
+
+	SharedVector(const vector_type & v_) : data(new vector_type(v_))
+	{
+	}
+
+	template <typename InputIterator>
+	SharedVector(InputIterator first_, InputIterator last_) : data(new vector_type(first_, last_))
+	{
+	}
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+	/// Takes over the buffer of the vector.
+	SharedVector(vector_type && v_) : data(new vector_type(std::move(v_)))
+	{
+	}
+
+	SharedVector & operator = (vector_type && v_) {
+		if (data && data.unique())
+			*data = std::move(v_);
+		else
+			data.reset(new vector_type(std::move(v_)));
+		return *this;
+	}
+#endif
+
+	SharedVector & operator = (const vector_type & v_) {
+		if (data && data.unique())
+			*data = v_;
+		else
+			data.reset(new vector_type(v_));
+		return *this;
+	}
+
+
+	/// Read-only access to the underlying vector.
+	const vector_type & get() const {
+		return data ? *data : emptyVector();
+	}
+
+	operator const vector_type & () const {
+		return get();
+	}
+
+	/// Write access to the underlying vector - detaches the buffer if it is shared.
+	vector_type & mutableVector() {
+		detach();
+		return *data;
+	}
+
+	/// Number of instances sharing the buffer (0 if no buffer was allocated yet).
+	long use_count() const {
+		return data.use_count();
+	}
+
+
+	size_type size() const { return get().size(); }
+	bool empty() const { return get().empty(); }
+	size_type capacity() const { return get().capacity(); }
+
+	const_iterator begin() const { return get().begin(); }
+	const_iterator end() const { return get().end(); }
+	const_reference operator[] (size_type i_) const { return get()[i_]; }
+	const_reference at(size_type i_) const { return get().at(i_); }
+	const_reference front() const { return get().front(); }
+	const_reference back() const { return get().back(); }
+
+	void push_back(const value_type & v_) { mutableVector().push_back(v_); }
+	void pop_back() { mutableVector().pop_back(); }
+	void reserve(size_type n_) { mutableVector().reserve(n_); }
+	void resize(size_type n_) { mutableVector().resize(n_); }
+	void resize(size_type n_, const value_type & v_) { mutableVector().resize(n_, v_); }
+
+	template <typename InputIterator>
+	void assign(InputIterator first_, InputIterator last_) {
+		if (data && data.unique())
+			data->assign(first_, last_);
+		else
+			data.reset(new vector_type(first_, last_));
+	}
+
+	/// Clears the vector - a shared buffer is simply released, not copied.
+	void clear() {
+		if (data && data.unique())
+			data->clear();
+		else
+			data.reset();
+	}
+
+	void swap(SharedVector & other_) {
+		data.swap(other_.data);
+	}
+
+	void swap(vector_type & v_) {
+		mutableVector().swap(v_);
+	}
+
+private:
+	/// Makes sure the buffer exists and is owned only by this instance.
+	void detach() {
+		if (!data)
+			data.reset(new vector_type);
+		else if (!data.unique())
+			data.reset(new vector_type(*data));
+	}
+
+	static const vector_type & emptyVector() {
+		static const vector_type empty;
+		return empty;
+	}
+
+	/// Shared buffer (NULL for empty, never modified vector).
+	boost::shared_ptr<vector_type> data;
+};
+
+} //: namespace Types
+
+#endif /* SHAREDVECTOR_HPP_ */
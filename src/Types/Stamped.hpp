@@ -0,0 +1,60 @@
+/*!
+ * \file Stamped.hpp
+ * \brief Message paired with its StreamStamp - payload of measured streams.
+ */
+
+#ifndef STAMPED_HPP_
+#define STAMPED_HPP_
+
+#include <Eigen/Core>
+
+#include "StreamStamp.hpp"
+
+namespace Types {
+
+/*!
+ * \class Stamped
+ * \brief Payload travelling together with its stamp in a single message.
+ *
+ * The stamp is kept next to the payload instead of in any of its fields, so the payload reaches consumers
+ * unmodified and a message can never be separated from its stamp.
+ */
+template <typename T>
+class Stamped {
+public:
+	/// Payload may be a fixed-size Eigen type (e.g. HomogMatrix).
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+	Stamped()
+	{
+	}
+
+	Stamped(const T & payload_, const StreamStamp & stamp_) :
+		m_payload(payload_), m_stamp(stamp_)
+	{
+	}
+
+	const T & payload() const {
+		return m_payload;
+	}
+
+	T & payload() {
+		return m_payload;
+	}
+
+	const StreamStamp & stamp() const {
+		return m_stamp;
+	}
+
+	void setStamp(const StreamStamp & stamp_) {
+		m_stamp = stamp_;
+	}
+
+private:
+	T m_payload;
+	StreamStamp m_stamp;
+};
+
+} //: namespace Types
+
+#endif /* STAMPED_HPP_ */
@@ -0,0 +1,67 @@
+/*!
+ * \file StreamStamp.hpp
+ * \brief Sequence number and send time of a message, used to measure throughput, drops and latency of streams.
+ */
+
+#ifndef STREAMSTAMP_HPP_
+#define STREAMSTAMP_HPP_
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+#else
+#include <boost/date_time/posix_time/posix_time.hpp>
+#endif
+
+#include <boost/cstdint.hpp>
+
+namespace Types {
+
+/*!
+ * \class StreamStamp
+ * \brief Stamp sent along with every message of a measured stream.
+ *
+ * Times are read from the monotonic clock (in nanoseconds), so latencies are meaningful only between
+ * components of the same machine.
+ */
+class StreamStamp {
+public:
+	StreamStamp(boost::uint64_t sequence_ = 0, boost::int64_t time_ = 0) :
+		m_sequence(sequence_), m_time(time_)
+	{
+	}
+
+	/// Number of the message, consecutive messages have consecutive numbers.
+	boost::uint64_t sequence() const {
+		return m_sequence;
+	}
+
+	/// Send time [ns].
+	boost::int64_t time() const {
+		return m_time;
+	}
+
+	/// Time elapsed since the message was sent [ns].
+	boost::int64_t age() const {
+		return now() - m_time;
+	}
+
+	/// Current time of the monotonic clock [ns].
+	static boost::int64_t now() {
+#if defined(__unix__) || defined(__APPLE__)
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (boost::int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+		static const boost::posix_time::ptime epoch = boost::posix_time::microsec_clock::universal_time();
+		return (boost::posix_time::microsec_clock::universal_time() - epoch).total_microseconds() * 1000;
+#endif
+	}
+
+private:
+	boost::uint64_t m_sequence;
+	boost::int64_t m_time;
+};
+
+} //: namespace Types
+
+#endif /* STREAMSTAMP_HPP_ */
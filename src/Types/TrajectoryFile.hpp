@@ -0,0 +1,294 @@
+/*!
+ * \file TrajectoryFile.hpp
+ * \brief Binary trajectory format - fixed-size records of XYZRPY poses with an optional timestamp column.
+ *
+ * Layout (native byte order): 32-byte TrajectoryFileHeader followed by records. Each record consists of
+ * an optional timestamp (double, seconds) and six doubles: x, y, z, roll, pitch, yaw.
+ */
+
+#ifndef TRAJECTORYFILE_HPP_
+#define TRAJECTORYFILE_HPP_
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <opencv2/core/core.hpp>
+
+namespace Types {
+
+/// Header of the binary trajectory file.
+struct TrajectoryFileHeader {
+	/// Magic string identifying the format.
+	char magic[8];
+
+	/// Format version.
+	uint32_t version;
+
+	/// Combination of TrajectoryFileFlags.
+	uint32_t flags;
+
+	/// Size of a single record in bytes.
+	uint32_t record_size;
+
+	/// Unused, keeps the header aligned.
+	uint32_t reserved;
+
+	/// Number of records - 0 if the file was not closed properly (count is then derived from the file size).
+	uint64_t count;
+};
+
+BOOST_STATIC_ASSERT(sizeof(TrajectoryFileHeader) == 32);
+
+/// Magic string of the binary trajectory file.
+static const char TRAJECTORY_FILE_MAGIC[8] = { 'D', 'C', 'L', 'T', 'R', 'A', 'J', '\0' };
+
+/// Current version of the format.
+static const uint32_t TRAJECTORY_FILE_VERSION = 1;
+
+/// Flags stored in the header.
+enum TrajectoryFileFlags {
+	/// Every record starts with a timestamp.
+	TRAJECTORY_TIMESTAMPS = 1
+};
+
+
+/*!
+ * \class TrajectoryReader
+ * \brief Memory-mapped, read-only view of the binary trajectory file.
+ *
+ * Records are accessed in O(1) directly in the mapping, so pages are loaded lazily by the OS on first access.
+ */
+class TrajectoryReader : private boost::noncopyable {
+public:
+	TrajectoryReader() :
+		records(NULL), record_doubles(0), count(0), timestamps(false)
+	{
+	}
+
+	/// Checks whether the file starts with the binary trajectory magic string.
+	static bool isTrajectoryFile(const std::string & filename_) {
+		char magic[sizeof(TRAJECTORY_FILE_MAGIC)];
+		std::FILE * f = std::fopen(filename_.c_str(), "rb");
+		if (!f)
+			return false;
+		bool ret = (std::fread(magic, 1, sizeof(magic), f) == sizeof(magic))
+				&& (std::memcmp(magic, TRAJECTORY_FILE_MAGIC, sizeof(magic)) == 0);
+		std::fclose(f);
+		return ret;
+	}
+
+	/// Maps the file. Throws std::runtime_error if the file is not a valid trajectory.
+	void open(const std::string & filename_) {
+		close();
+
+		boost::interprocess::file_mapping file(filename_.c_str(), boost::interprocess::read_only);
+		boost::interprocess::mapped_region region(file, boost::interprocess::read_only);
+
+		if (region.get_size() < sizeof(TrajectoryFileHeader))
+			throw std::runtime_error("Trajectory file too short: " + filename_);
+
+		const TrajectoryFileHeader * header = static_cast<const TrajectoryFileHeader *>(region.get_address());
+		if (std::memcmp(header->magic, TRAJECTORY_FILE_MAGIC, sizeof(TRAJECTORY_FILE_MAGIC)) != 0)
+			throw std::runtime_error("Not a trajectory file: " + filename_);
+		if (header->version != TRAJECTORY_FILE_VERSION)
+			throw std::runtime_error("Unsupported trajectory file version: " + filename_);
+
+		bool ts = (header->flags & TRAJECTORY_TIMESTAMPS) != 0;
+		size_t rd = ts ? 7 : 6;
+		if (header->record_size != rd * sizeof(double))
+			throw std::runtime_error("Invalid record size in trajectory file: " + filename_);
+
+		// Trust the header only as far as the records are really present in the file.
+		uint64_t available = (region.get_size() - sizeof(TrajectoryFileHeader)) / header->record_size;
+		count = (header->count == 0 || header->count > available) ? available : header->count;
+		timestamps = ts;
+		record_doubles = rd;
+
+		region.swap(mapping);
+		records = reinterpret_cast<const double *>(static_cast<const char *>(mapping.get_address()) + sizeof(TrajectoryFileHeader));
+	}
+
+	/// Unmaps the file.
+	void close() {
+		boost::interprocess::mapped_region empty;
+		mapping.swap(empty);
+		records = NULL;
+		record_doubles = 0;
+		count = 0;
+		timestamps = false;
+	}
+
+	/// Returns true if the file is mapped.
+	bool isOpen() const {
+		return records != NULL;
+	}
+
+	/// Number of poses in the trajectory.
+	size_t size() const {
+		return count;
+	}
+
+	/// Returns true if records contain timestamps.
+	bool hasTimestamps() const {
+		return timestamps;
+	}
+
+	/// Returns pose with given index in the form of XYZRPY.
+	cv::Vec6d xyzrpy(size_t index_) const {
+		const double * r = record(index_) + (timestamps ? 1 : 0);
+		return cv::Vec6d(r[0], r[1], r[2], r[3], r[4], r[5]);
+	}
+
+	/// Returns timestamp of pose with given index (0 if timestamps are not stored).
+	double timestamp(size_t index_) const {
+		return timestamps ? record(index_)[0] : 0.0;
+	}
+
+	/// Asks the OS to read ahead records [begin, begin + n) - returns immediately, pages are loaded in the background.
+	void prefetch(size_t begin_, size_t n_) const {
+		if (!records || begin_ >= count)
+			return;
+		if (n_ > count - begin_)
+			n_ = count - begin_;
+		const uintptr_t page = boost::interprocess::mapped_region::get_page_size();
+		uintptr_t from = reinterpret_cast<uintptr_t>(record(begin_)) & ~(page - 1);
+		uintptr_t to = reinterpret_cast<uintptr_t>(record(begin_ + n_));
+		::posix_madvise(reinterpret_cast<void *>(from), to - from, POSIX_MADV_WILLNEED);
+	}
+
+private:
+	const double * record(size_t index_) const {
+		return records + index_ * record_doubles;
+	}
+
+	/// Mapped file.
+	boost::interprocess::mapped_region mapping;
+
+	/// First record.
+	const double * records;
+
+	/// Size of a record (in doubles).
+	size_t record_doubles;
+
+	/// Number of records.
+	size_t count;
+
+	/// Flag indicating whether records contain timestamps.
+	bool timestamps;
+};
+
+
+/*!
+ * \class TrajectoryWriter
+ * \brief Append-only writer of the binary trajectory file.
+ *
+ * The number of records is written into the header on close(). Files that were not closed are still readable,
+ * as the reader then derives the number of records from the file size.
+ */
+class TrajectoryWriter : private boost::noncopyable {
+public:
+	TrajectoryWriter() :
+		file(NULL), count(0), timestamps(false)
+	{
+	}
+
+	~TrajectoryWriter() {
+		close();
+	}
+
+	/// Creates (truncates) the file and writes the header. Throws std::runtime_error on failure.
+	void open(const std::string & filename_, bool timestamps_) {
+		close();
+
+		file = std::fopen(filename_.c_str(), "wb");
+		if (!file)
+			throw std::runtime_error("Could not create trajectory file: " + filename_);
+
+		timestamps = timestamps_;
+		count = 0;
+		if (!writeHeader())
+			throw std::runtime_error("Could not write trajectory file header: " + filename_);
+	}
+
+	/// Appends pose in the form of XYZRPY (timestamp is ignored if the file has no timestamp column).
+	void append(const cv::Vec6d & xyzrpy_, double timestamp_ = 0) {
+		double r[7];
+		size_t n = 0;
+		if (timestamps)
+			r[n++] = timestamp_;
+		for (int i = 0; i < 6; ++i)
+			r[n++] = xyzrpy_[i];
+		if (std::fwrite(r, sizeof(double), n, file) != n)
+			throw std::runtime_error("Could not write to trajectory file");
+		++count;
+	}
+
+	/// Appends a block of raw records (already laid out as in the file).
+	void appendRecords(const double * records_, size_t n_) {
+		size_t doubles = n_ * (timestamps ? 7 : 6);
+		if (std::fwrite(records_, sizeof(double), doubles, file) != doubles)
+			throw std::runtime_error("Could not write to trajectory file");
+		count += n_;
+	}
+
+	/// Flushes the buffered records to the file.
+	void flush() {
+		if (file)
+			std::fflush(file);
+	}
+
+	/// Writes the number of records into the header and closes the file.
+	void close() {
+		if (!file)
+			return;
+		std::fseek(file, 0, SEEK_SET);
+		writeHeader();
+		std::fclose(file);
+		file = NULL;
+	}
+
+	/// Returns true if the file is open.
+	bool isOpen() const {
+		return file != NULL;
+	}
+
+	/// Number of records written so far.
+	uint64_t size() const {
+		return count;
+	}
+
+private:
+	bool writeHeader() {
+		TrajectoryFileHeader header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, TRAJECTORY_FILE_MAGIC, sizeof(TRAJECTORY_FILE_MAGIC));
+		header.version = TRAJECTORY_FILE_VERSION;
+		header.flags = timestamps ? TRAJECTORY_TIMESTAMPS : 0;
+		header.record_size = (timestamps ? 7 : 6) * sizeof(double);
+		header.count = count;
+		return std::fwrite(&header, sizeof(header), 1, file) == 1;
+	}
+
+	/// Output file.
+	std::FILE * file;
+
+	/// Number of records written.
+	uint64_t count;
+
+	/// Flag indicating whether records contain timestamps.
+	bool timestamps;
+};
+
+} // namespace Types
+
+#endif /* TRAJECTORYFILE_HPP_ */